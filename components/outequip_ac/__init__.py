@@ -1,25 +1,212 @@
+from pathlib import Path
+
 import esphome.codegen as cg
 import esphome.config_validation as cv
-from esphome.components import uart
-from esphome.const import CONF_ID
+from esphome import automation
+from esphome.components import climate, time as time_, uart
+from esphome.const import (
+    CONF_ABOVE,
+    CONF_BELOW,
+    CONF_BUFFER_SIZE,
+    CONF_FAN_MODE,
+    CONF_FILE,
+    CONF_HOUR,
+    CONF_ID,
+    CONF_MINUTE,
+    CONF_MODE,
+    CONF_TARGET_TEMPERATURE,
+    CONF_THEN,
+    CONF_TIME,
+    CONF_TIME_ID,
+    CONF_TRIGGER_ID,
+    CONF_URL,
+)
 
 import esphome.final_validate as fv
 
+from . import web_assets
+
 CODEOWNERS = ["@gongloo"]
 DEPENDENCIES = ["uart"]
+DOMAIN = "outequip_ac"
 MULTI_CONF = True
 
 outequip_ac_ns = cg.esphome_ns.namespace("outequip_ac")
 OutEquipAC = outequip_ac_ns.class_("OutEquipAC", cg.Component, uart.UARTDevice)
+OutEquipACAssetHandler = outequip_ac_ns.class_("OutEquipACAssetHandler")
+GroupControlAction = outequip_ac_ns.class_("GroupControlAction", automation.Action)
+ApplySceneAction = outequip_ac_ns.class_("ApplySceneAction", automation.Action)
+SceneCompleteTrigger = outequip_ac_ns.class_(
+    "SceneCompleteTrigger", automation.Trigger.template(cg.bool_)
+)
+RuleInput = cg.global_ns.enum("RuleEngine::Input", is_class=True)
 
 CONF_OUTEQUIP_AC_ID = "outequip_ac_id"
+CONF_WEB_ASSETS = "web_assets"
+CONF_WEB_ASSETS_ID = "web_assets_id"
+CONF_CONTENT_TYPE = "content_type"
+CONF_CACHE_CONTROL = "cache_control"
+CONF_RAW_DATA_ID = "raw_data_id"
+CONF_GZIP_DATA_ID = "gzip_data_id"
+CONF_BR_DATA_ID = "br_data_id"
+CONF_PASSTHROUGH_UART_ID = "passthrough_uart_id"
+CONF_UNIT_NAME = "unit_name"
+CONF_UNITS = "units"
+CONF_STAGGER = "stagger"
+CONF_EVENT_LEVEL = "event_level"
+CONF_LOG_EVENTS = "log_events"
+CONF_RULES = "rules"
+CONF_VOLTAGE = "voltage"
+CONF_INTAKE_TEMP = "intake_temp"
+CONF_HYSTERESIS = "hysteresis"
+CONF_ON_CLEAR = "on_clear"
+CONF_LCD = "lcd"
+CONF_LIGHT = "light"
+CONF_ON_SCENE_COMPLETE = "on_scene_complete"
+CONF_TELEMETRY = "telemetry"
+CONF_FLASH_BLOCKS = "flash_blocks"
+CONF_MAX_PACKET_SIZE = "max_packet_size"
+CONF_CONFIRM_DELIVERY = "confirm_delivery"
+
+RULE_INPUTS = {
+    CONF_VOLTAGE: RuleInput.Voltage,
+    CONF_INTAKE_TEMP: RuleInput.IntakeTemp,
+}
+
+# Must match EventLog::Level.
+EVENT_LEVELS = {
+    "VERBOSE": 0,
+    "DEBUG": 1,
+    "INFO": 2,
+    "WARN": 3,
+}
+
+def validate_unit_name(value):
+    value = cv.string_strict(value)
+    # Goes into InfluxDB tags and URL query strings unescaped.
+    if not value or not all(c.isalnum() or c in "-_" for c in value):
+        raise cv.Invalid("Unit name may only contain letters, digits, '-' and '_'")
+    return value
+
+def validate_asset_url(value):
+    value = cv.string_strict(value)
+    if not value.startswith("/"):
+        raise cv.Invalid("Asset URL must start with '/'")
+    return value
+
+WEB_ASSET_SCHEMA = cv.Schema({
+    cv.Required(CONF_FILE): cv.file_,
+    cv.Required(CONF_URL): validate_asset_url,
+    cv.Optional(CONF_CONTENT_TYPE): cv.string_strict,
+    cv.Optional(CONF_CACHE_CONTROL): cv.string_strict,
+    cv.GenerateID(CONF_RAW_DATA_ID): cv.declare_id(cg.uint8),
+    cv.GenerateID(CONF_GZIP_DATA_ID): cv.declare_id(cg.uint8),
+    cv.GenerateID(CONF_BR_DATA_ID): cv.declare_id(cg.uint8),
+})
+
+RULE_ACTION_SCHEMA = cv.All(
+    cv.Schema({
+        cv.Optional(CONF_MODE): climate.validate_climate_mode,
+        cv.Optional(CONF_TARGET_TEMPERATURE): cv.temperature,
+        cv.Optional(CONF_FAN_MODE): climate.validate_climate_fan_mode,
+    }),
+    cv.has_at_least_one_key(CONF_MODE, CONF_TARGET_TEMPERATURE, CONF_FAN_MODE),
+)
+
+RULE_THRESHOLD_SCHEMA = cv.All(
+    cv.Schema({
+        cv.Optional(CONF_ABOVE): cv.float_,
+        cv.Optional(CONF_BELOW): cv.float_,
+        cv.Optional(CONF_HYSTERESIS, default=0): cv.positive_float,
+    }),
+    cv.has_exactly_one_key(CONF_ABOVE, CONF_BELOW),
+)
+
+def validate_rule(config):
+    if CONF_TIME in config and CONF_ON_CLEAR in config:
+        raise cv.Invalid(f"'{CONF_ON_CLEAR}' only applies to threshold rules")
+    return config
+
+RULE_SCHEMA = cv.All(
+    cv.Schema({
+        cv.Optional(CONF_VOLTAGE): RULE_THRESHOLD_SCHEMA,
+        cv.Optional(CONF_INTAKE_TEMP): RULE_THRESHOLD_SCHEMA,
+        cv.Optional(CONF_TIME): cv.time_of_day,
+        cv.Required(CONF_THEN): RULE_ACTION_SCHEMA,
+        cv.Optional(CONF_ON_CLEAR): RULE_ACTION_SCHEMA,
+    }),
+    cv.has_exactly_one_key(CONF_VOLTAGE, CONF_INTAKE_TEMP, CONF_TIME),
+    validate_rule,
+)
+
+TELEMETRY_SCHEMA = cv.Schema({
+    cv.Optional(CONF_BUFFER_SIZE, default="16kB"): cv.All(
+        cv.validate_bytes, cv.int_range(min=1024, max=131072)
+    ),
+    # 1 kB preference blocks to spill to once the RAM buffer is full. They
+    # share the 20 kB NVS partition with every other preference, so keep
+    # them to a few.
+    cv.Optional(CONF_FLASH_BLOCKS, default=0): cv.int_range(min=0, max=4),
+    cv.Optional(CONF_MAX_PACKET_SIZE, default=1400): cv.int_range(
+        min=256, max=65000
+    ),
+    # Hold each packet until OutEquipACHub::TelemetryDelivered() reports it
+    # arrived; UDP alone can't tell.
+    cv.Optional(CONF_CONFIRM_DELIVERY, default=False): cv.boolean,
+})
+
+def validate_time_id(config):
+    has_schedule = any(CONF_TIME in rule for rule in config.get(CONF_RULES, []))
+    if has_schedule and CONF_TIME_ID not in config:
+        raise cv.Invalid(f"Rules with '{CONF_TIME}' require '{CONF_TIME_ID}'")
+    if CONF_TELEMETRY in config and CONF_TIME_ID not in config:
+        raise cv.Invalid(f"'{CONF_TELEMETRY}' requires '{CONF_TIME_ID}'")
+    return config
 
 CONFIG_SCHEMA = cv.Schema({
     cv.GenerateID(): cv.declare_id(OutEquipAC),
+    cv.GenerateID(CONF_WEB_ASSETS_ID): cv.declare_id(OutEquipACAssetHandler),
+    cv.Optional(CONF_WEB_ASSETS): cv.ensure_list(WEB_ASSET_SCHEMA),
+    # UART wired to the original Bluetooth module, for inline passthrough.
+    cv.Optional(CONF_PASSTHROUGH_UART_ID): cv.use_id(uart.UARTComponent),
+    # Tags stats and selects the unit on /outequip_ac/state when several units
+    # share one ESP32.
+    cv.Optional(CONF_UNIT_NAME): validate_unit_name,
+    # Events below this level are compiled out of the event log.
+    cv.Optional(CONF_EVENT_LEVEL, default="DEBUG"): cv.enum(
+        EVENT_LEVELS, upper=True
+    ),
+    # Events are only formatted when read from /outequip_ac/log, unless this
+    # also sends them to the logger.
+    cv.Optional(CONF_LOG_EVENTS, default=False): cv.boolean,
+    # Evaluated on the device as readings arrive, independent of the network.
+    cv.Optional(CONF_RULES): cv.ensure_list(RULE_SCHEMA),
+    cv.Optional(CONF_TIME_ID): cv.use_id(time_.RealTimeClock),
+    # Queue stats reports (OutEquipACHub::QueueReport) with timestamps, to
+    # be sent once the network is back. Configure on one unit only.
+    cv.Optional(CONF_TELEMETRY): TELEMETRY_SCHEMA,
+    # Runs once per outequip_ac.apply_scene, with whether the board confirmed
+    # every frame sent for it.
+    cv.Optional(CONF_ON_SCENE_COMPLETE): automation.validate_automation({
+        cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(SceneCompleteTrigger),
+    }),
 }).extend(uart.UART_DEVICE_SCHEMA).extend(cv.COMPONENT_SCHEMA)
 
+CONFIG_SCHEMA = cv.All(CONFIG_SCHEMA, validate_time_id)
+
 def final_validate(config):
     full_config = fv.full_config.get()
+    # OUTEQUIP_AC_EVENT_LEVEL is a single define shared by every unit.
+    levels = {unit[CONF_EVENT_LEVEL] for unit in full_config[DOMAIN]}
+    if len(levels) > 1:
+        raise cv.Invalid(
+            f"'{CONF_EVENT_LEVEL}' must be the same on every outequip_ac unit"
+        )
+    # The hub has one telemetry queue and one set of flash blocks.
+    if sum(CONF_TELEMETRY in unit for unit in full_config[DOMAIN]) > 1:
+        raise cv.Invalid(
+            f"'{CONF_TELEMETRY}' can only be set on one outequip_ac unit"
+        )
     if "web_server" in full_config:
         web_server_config = full_config["web_server"]
         if isinstance(web_server_config, list):
@@ -27,13 +214,186 @@ def final_validate(config):
                 ws["log"] = False
         elif isinstance(web_server_config, dict):
             web_server_config["log"] = False
+    elif CONF_WEB_ASSETS in config:
+        raise cv.Invalid(f"'{CONF_WEB_ASSETS}' requires 'web_server'")
     return config
 
 FINAL_VALIDATE_SCHEMA = final_validate
 
+async def web_assets_to_code(var, config):
+    handler = cg.new_Pvariable(config[CONF_WEB_ASSETS_ID])
+    substitutions = web_assets.default_substitutions()
+    data_ids = {
+        "": CONF_RAW_DATA_ID,
+        "gzip": CONF_GZIP_DATA_ID,
+        "br": CONF_BR_DATA_ID,
+    }
+    for conf in config[CONF_WEB_ASSETS]:
+        path = Path(conf[CONF_FILE])
+        content_type = conf.get(CONF_CONTENT_TYPE, web_assets.content_type_for(path))
+        cache_control = conf.get(
+            CONF_CACHE_CONTROL, web_assets.default_cache_control(content_type)
+        )
+        _, variants = web_assets.build_asset(path, content_type, substitutions)
+        cg.add(handler.add_asset(conf[CONF_URL], content_type, cache_control))
+        for encoding, data in variants:
+            arr = cg.progmem_array(conf[data_ids[encoding]], list(data))
+            cg.add(
+                handler.add_variant(
+                    encoding, arr, len(data), web_assets.etag_for(data)
+                )
+            )
+    cg.add(var.set_asset_handler(handler))
+
+def rule_action_to_code(var, config, on_clear):
+    if CONF_MODE in config:
+        mode = climate.CLIMATE_MODES[config[CONF_MODE]]
+        cg.add(var.set_rule_mode(on_clear, mode))
+    if CONF_TARGET_TEMPERATURE in config:
+        target = config[CONF_TARGET_TEMPERATURE]
+        cg.add(var.set_rule_target_temperature(on_clear, target))
+    if CONF_FAN_MODE in config:
+        fan_mode = climate.CLIMATE_FAN_MODES[config[CONF_FAN_MODE]]
+        cg.add(var.set_rule_fan_mode(on_clear, fan_mode))
+
+def rules_to_code(var, config):
+    for rule in config.get(CONF_RULES, []):
+        if CONF_TIME in rule:
+            at = rule[CONF_TIME]
+            cg.add(var.add_schedule_rule(at[CONF_HOUR] * 60 + at[CONF_MINUTE]))
+        else:
+            key = CONF_VOLTAGE if CONF_VOLTAGE in rule else CONF_INTAKE_TEMP
+            if key == CONF_VOLTAGE:
+                # Voltage must be polled even without a voltage sensor.
+                cg.add_define("USE_OUTEQUIP_AC_VOLTAGE_RULES")
+            threshold = rule[key]
+            above = CONF_ABOVE in threshold
+            cg.add(var.add_threshold_rule(
+                RULE_INPUTS[key],
+                threshold[CONF_ABOVE] if above else threshold[CONF_BELOW],
+                above,
+                threshold[CONF_HYSTERESIS],
+            ))
+        rule_action_to_code(var, rule[CONF_THEN], False)
+        if CONF_ON_CLEAR in rule:
+            rule_action_to_code(var, rule[CONF_ON_CLEAR], True)
+
+GROUP_CONTROL_SCHEMA = cv.All(
+    cv.Schema({
+        cv.GenerateID(): cv.declare_id(GroupControlAction),
+        cv.Required(CONF_UNITS): cv.ensure_list(cv.use_id(OutEquipAC)),
+        cv.Optional(CONF_MODE): cv.templatable(climate.validate_climate_mode),
+        cv.Optional(CONF_TARGET_TEMPERATURE): cv.templatable(cv.temperature),
+        cv.Optional(CONF_FAN_MODE): cv.templatable(
+            climate.validate_climate_fan_mode
+        ),
+        cv.Optional(CONF_STAGGER, default="2s"):
+            cv.positive_time_period_milliseconds,
+    }),
+    cv.has_at_least_one_key(CONF_MODE, CONF_TARGET_TEMPERATURE, CONF_FAN_MODE),
+)
+
+@automation.register_action(
+    "outequip_ac.group_control", GroupControlAction, GROUP_CONTROL_SCHEMA
+)
+async def group_control_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    for unit_id in config[CONF_UNITS]:
+        unit = await cg.get_variable(unit_id)
+        cg.add(var.add_unit(unit))
+    cg.add(var.set_stagger(config[CONF_STAGGER]))
+    if CONF_MODE in config:
+        template_ = await cg.templatable(
+            config[CONF_MODE], args, climate.ClimateMode
+        )
+        cg.add(var.set_mode(template_))
+    if CONF_TARGET_TEMPERATURE in config:
+        template_ = await cg.templatable(
+            config[CONF_TARGET_TEMPERATURE], args, cg.float_
+        )
+        cg.add(var.set_target_temperature(template_))
+    if CONF_FAN_MODE in config:
+        template_ = await cg.templatable(
+            config[CONF_FAN_MODE], args, climate.ClimateFanMode
+        )
+        cg.add(var.set_fan_mode(template_))
+    return var
+
+APPLY_SCENE_SCHEMA = cv.All(
+    cv.Schema({
+        cv.GenerateID(): cv.use_id(OutEquipAC),
+        cv.Optional(CONF_MODE): cv.templatable(climate.validate_climate_mode),
+        # Give a unit (70°F); bare numbers and lambdas are °C. Out-of-range
+        # values are ignored at runtime, see OutEquipAC::ApplyScene().
+        cv.Optional(CONF_TARGET_TEMPERATURE): cv.templatable(cv.temperature),
+        cv.Optional(CONF_FAN_MODE): cv.templatable(
+            climate.validate_climate_fan_mode
+        ),
+        cv.Optional(CONF_LCD): cv.templatable(cv.boolean),
+        cv.Optional(CONF_LIGHT): cv.templatable(cv.boolean),
+    }),
+    cv.has_at_least_one_key(
+        CONF_MODE, CONF_TARGET_TEMPERATURE, CONF_FAN_MODE, CONF_LCD, CONF_LIGHT
+    ),
+)
+
+@automation.register_action(
+    "outequip_ac.apply_scene", ApplySceneAction, APPLY_SCENE_SCHEMA
+)
+async def apply_scene_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    if CONF_MODE in config:
+        template_ = await cg.templatable(
+            config[CONF_MODE], args, climate.ClimateMode
+        )
+        cg.add(var.set_mode(template_))
+    if CONF_TARGET_TEMPERATURE in config:
+        template_ = await cg.templatable(
+            config[CONF_TARGET_TEMPERATURE], args, cg.float_
+        )
+        cg.add(var.set_target_temperature(template_))
+    if CONF_FAN_MODE in config:
+        template_ = await cg.templatable(
+            config[CONF_FAN_MODE], args, climate.ClimateFanMode
+        )
+        cg.add(var.set_fan_mode(template_))
+    if CONF_LCD in config:
+        template_ = await cg.templatable(config[CONF_LCD], args, cg.bool_)
+        cg.add(var.set_lcd(template_))
+    if CONF_LIGHT in config:
+        template_ = await cg.templatable(config[CONF_LIGHT], args, cg.bool_)
+        cg.add(var.set_light(template_))
+    return var
+
 async def to_code(config):
     var = cg.new_Pvariable(config[CONF_ID])
     await cg.register_component(var, config)
     await uart.register_uart_device(var, config)
-
-
+    if CONF_PASSTHROUGH_UART_ID in config:
+        passthrough_uart = await cg.get_variable(config[CONF_PASSTHROUGH_UART_ID])
+        cg.add(var.set_passthrough_uart(passthrough_uart))
+    if CONF_UNIT_NAME in config:
+        cg.add(var.set_unit_name(config[CONF_UNIT_NAME]))
+    cg.add_define("OUTEQUIP_AC_EVENT_LEVEL", config[CONF_EVENT_LEVEL])
+    if config[CONF_LOG_EVENTS]:
+        cg.add(var.set_log_events(True))
+    if CONF_WEB_ASSETS in config:
+        await web_assets_to_code(var, config)
+    rules_to_code(var, config)
+    if CONF_TIME_ID in config:
+        cg.add_define("USE_OUTEQUIP_AC_TIME")
+        clock = await cg.get_variable(config[CONF_TIME_ID])
+        cg.add(var.set_time(clock))
+    if CONF_TELEMETRY in config:
+        telemetry = config[CONF_TELEMETRY]
+        cg.add_define("USE_OUTEQUIP_AC_TELEMETRY")
+        cg.add(var.set_telemetry(
+            telemetry[CONF_BUFFER_SIZE],
+            telemetry[CONF_FLASH_BLOCKS],
+            telemetry[CONF_MAX_PACKET_SIZE],
+            telemetry[CONF_CONFIRM_DELIVERY],
+        ))
+    for conf in config.get(CONF_ON_SCENE_COMPLETE, []):
+        trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
+        await automation.build_automation(trigger, [(cg.bool_, "success")], conf)
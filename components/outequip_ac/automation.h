@@ -0,0 +1,111 @@
+#pragma once
+
+#include "outequip_ac.h"
+#include "esphome/core/automation.h"
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace esphome {
+namespace outequip_ac {
+
+// Applies one climate command to a group of units. Each unit after the first
+// is delayed by a further `stagger`, so compressors don't all start at once on
+// a shared battery.
+template <typename... Ts> class GroupControlAction : public Action<Ts...> {
+public:
+  void add_unit(OutEquipAC *unit) { units_.push_back(unit); }
+  void set_stagger(uint32_t stagger) { stagger_ = stagger; }
+
+  TEMPLATABLE_VALUE(climate::ClimateMode, mode)
+  TEMPLATABLE_VALUE(float, target_temperature)
+  TEMPLATABLE_VALUE(climate::ClimateFanMode, fan_mode)
+
+  void play(const Ts &...x) override {
+    for (size_t i = 0; i < units_.size(); ++i) {
+      auto call = units_[i]->make_call();
+      if (mode_.has_value())
+        call.set_mode(mode_.value(x...));
+      if (target_temperature_.has_value())
+        call.set_target_temperature(target_temperature_.value(x...));
+      if (fan_mode_.has_value())
+        call.set_fan_mode(fan_mode_.value(x...));
+      units_[i]->control_after(i * stagger_, call);
+    }
+  }
+
+protected:
+  std::vector<OutEquipAC *> units_;
+  uint32_t stagger_{0};
+};
+
+// Applies a scene to one unit, sending only what differs from the board's
+// confirmed state. on_scene_complete reports once the board confirms it.
+template <typename... Ts>
+class ApplySceneAction : public Action<Ts...>, public Parented<OutEquipAC> {
+public:
+  TEMPLATABLE_VALUE(climate::ClimateMode, mode)
+  TEMPLATABLE_VALUE(float, target_temperature)
+  TEMPLATABLE_VALUE(climate::ClimateFanMode, fan_mode)
+  TEMPLATABLE_VALUE(bool, lcd)
+  TEMPLATABLE_VALUE(bool, light)
+
+  void play(const Ts &...x) override {
+    ScenePlanner::Scene scene;
+    if (mode_.has_value())
+      OutEquipAC::AddClimateMode(scene, mode_.value(x...));
+    if (target_temperature_.has_value())
+      OutEquipAC::AddTargetTemperature(scene, target_temperature_.value(x...));
+    if (fan_mode_.has_value())
+      OutEquipAC::AddFanMode(scene, fan_mode_.value(x...));
+    if (lcd_.has_value())
+      OutEquipAC::AddLcd(scene, lcd_.value(x...));
+    if (light_.has_value())
+      OutEquipAC::AddLight(scene, light_.value(x...));
+    this->parent_->ApplyScene(scene, true);
+  }
+};
+
+class SceneCompleteTrigger : public Trigger<bool> {
+public:
+  explicit SceneCompleteTrigger(OutEquipAC *parent) {
+    parent->add_on_scene_complete_callback(
+        [this](bool success) { this->trigger(success); });
+  }
+};
+
+// Builds a scene from API service arguments, where an empty string or a
+// non-positive temperature leaves that setting as it is. Names match the
+// ESPHome enums: OFF/COOL/HEAT/FAN_ONLY, LOW/MEDIUM/HIGH and ON/OFF. The
+// temperature is in °C; ApplyScene() ignores one outside the unit's range.
+inline ScenePlanner::Scene SceneFromStrings(const std::string &mode,
+                                            float target_temperature_c,
+                                            const std::string &fan_mode,
+                                            const std::string &lcd,
+                                            const std::string &light) {
+  ScenePlanner::Scene scene;
+  if (mode == "OFF")
+    OutEquipAC::AddClimateMode(scene, climate::CLIMATE_MODE_OFF);
+  else if (mode == "COOL")
+    OutEquipAC::AddClimateMode(scene, climate::CLIMATE_MODE_COOL);
+  else if (mode == "HEAT")
+    OutEquipAC::AddClimateMode(scene, climate::CLIMATE_MODE_HEAT);
+  else if (mode == "FAN_ONLY")
+    OutEquipAC::AddClimateMode(scene, climate::CLIMATE_MODE_FAN_ONLY);
+  if (!std::isnan(target_temperature_c) && target_temperature_c > 0)
+    OutEquipAC::AddTargetTemperature(scene, target_temperature_c);
+  if (fan_mode == "LOW")
+    OutEquipAC::AddFanMode(scene, climate::CLIMATE_FAN_LOW);
+  else if (fan_mode == "MEDIUM")
+    OutEquipAC::AddFanMode(scene, climate::CLIMATE_FAN_MEDIUM);
+  else if (fan_mode == "HIGH")
+    OutEquipAC::AddFanMode(scene, climate::CLIMATE_FAN_HIGH);
+  if (lcd == "ON" || lcd == "OFF")
+    OutEquipAC::AddLcd(scene, lcd == "ON");
+  if (light == "ON" || light == "OFF")
+    OutEquipAC::AddLight(scene, light == "ON");
+  return scene;
+}
+
+} // namespace outequip_ac
+} // namespace esphome
@@ -0,0 +1,37 @@
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome.components import button
+from esphome.const import CONF_DURATION, ENTITY_CATEGORY_DIAGNOSTIC
+from . import outequip_ac_ns, OutEquipAC, CONF_OUTEQUIP_AC_ID
+
+DEPENDENCIES = ["outequip_ac"]
+
+CONF_BENCHMARK = "benchmark"
+
+OutEquipACBenchmarkButton = outequip_ac_ns.class_(
+    "OutEquipACBenchmarkButton", button.Button
+)
+
+CONFIG_SCHEMA = cv.Schema({
+    cv.GenerateID(CONF_OUTEQUIP_AC_ID): cv.use_id(OutEquipAC),
+    # Floods the link with queries for `duration`, then publishes the
+    # benchmark sensors (see sensor.py).
+    cv.Optional(CONF_BENCHMARK): button.button_schema(
+        OutEquipACBenchmarkButton,
+        icon="mdi:speedometer",
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+    ).extend({
+        cv.Optional(CONF_DURATION, default="10s"):
+            cv.positive_time_period_milliseconds,
+    }),
+})
+
+async def to_code(config):
+    parent = await cg.get_variable(config[CONF_OUTEQUIP_AC_ID])
+
+    if CONF_BENCHMARK in config:
+        conf = config[CONF_BENCHMARK]
+        cg.add_define("USE_OUTEQUIP_AC_BENCHMARK")
+        btn = await button.new_button(conf)
+        cg.add(btn.set_parent(parent))
+        cg.add(parent.set_benchmark_duration(conf[CONF_DURATION]))
@@ -0,0 +1,66 @@
+#include "event_log.h"
+
+#include <cstdio>
+
+void EventLog::Push(const Event &event) {
+  events_[next_seq_ % kCapacity] = event;
+  next_seq_++;
+}
+
+bool EventLog::Get(uint32_t seq, Event *out) const {
+  if (seq < first_seq() || seq >= next_seq_) {
+    return false;
+  }
+  *out = events_[seq % kCapacity];
+  return true;
+}
+
+size_t EventLog::Format(const Event &event, char *buf, size_t len) {
+  if (len == 0) {
+    return 0;
+  }
+
+  const auto key = static_cast<ACFramer::Key>(event.key);
+  const char *value_str = "";
+  ACFramer framer;
+  if (ACFramer::ValidateKey(event.key) &&
+      framer.NewFrame(key, event.value, true)) {
+    value_str = framer.GetValueAsString();
+  }
+
+  int n = 0;
+  switch (event.id) {
+    case Id::FrameRx:
+      n = snprintf(buf, len, "rx %s=%s", ACFramer::KeyToString(key),
+                   value_str);
+      break;
+    case Id::FrameTx:
+      n = snprintf(buf, len, "tx %s=%s", ACFramer::KeyToString(key),
+                   event.value == ACFramer::kQueryVal ? "?" : value_str);
+      break;
+    case Id::SpuriousByte:
+      n = snprintf(buf, len, "Spurious byte 0x%02x", event.key);
+      break;
+    case Id::FrameFailed:
+      n = snprintf(buf, len, "Dropped invalid frame after %u bytes",
+                   event.value);
+      break;
+    case Id::StateChanged:
+      n = snprintf(buf, len, "%s changed to %s", ACFramer::KeyToString(key),
+                   value_str);
+      break;
+    case Id::Command:
+      n = snprintf(buf, len, "Setting %s to %s", ACFramer::KeyToString(key),
+                   value_str);
+      break;
+    case Id::RuleFired:
+      n = snprintf(buf, len, "Rule %u %s", event.key,
+                   event.value ? "cleared" : "fired");
+      break;
+  }
+  if (n < 0) {
+    buf[0] = '\0';
+    return 0;
+  }
+  return static_cast<size_t>(n) < len ? n : len - 1;
+}
@@ -0,0 +1,131 @@
+#ifndef __EVENT_LOG_H__
+#define __EVENT_LOG_H__
+
+#include "ac_framer.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Minimum level recorded; lower levels compile to nothing. Set by the
+// `event_level` option in __init__.py, so defines.h must come first.
+#if __has_include("esphome/core/defines.h")
+#include "esphome/core/defines.h"
+#endif
+#ifndef OUTEQUIP_AC_EVENT_LEVEL
+#define OUTEQUIP_AC_EVENT_LEVEL 1
+#endif
+
+// Fixed-size ring of binary events. Recording copies an id, a timestamp and
+// the raw key/value off the wire; nothing is formatted until a reader asks.
+class EventLog {
+public:
+  enum class Level : uint8_t { Verbose = 0, Debug, Info, Warn };
+
+  enum class Id : uint8_t {
+    // A frame was received from the board. key, value.
+    FrameRx = 0,
+    // A frame was sent to the board. key, value.
+    FrameTx,
+    // A byte arrived outside of any frame. arg: the byte.
+    SpuriousByte,
+    // A partial frame failed to validate. arg: bytes received so far.
+    FrameFailed,
+    // A polled key reported a new value. key, value.
+    StateChanged,
+    // A command was queued for the board. key, value.
+    Command,
+    // A local rule fired. key: rule index, value: 1 if it cleared.
+    RuleFired,
+  };
+
+  struct Event {
+    uint32_t at;
+    Id id;
+    uint8_t key;
+    uint16_t value;
+  };
+
+  static const size_t kCapacity = 64;
+
+  static constexpr Level LevelOf(Id id) {
+    switch (id) {
+    case Id::FrameRx:
+    case Id::FrameTx:
+    case Id::SpuriousByte:
+      return Level::Verbose;
+    case Id::StateChanged:
+      return Level::Debug;
+    case Id::Command:
+    case Id::RuleFired:
+      return Level::Info;
+    case Id::FrameFailed:
+      return Level::Warn;
+    }
+    return Level::Warn;
+  }
+
+  static constexpr const char *LevelToString(Level level) {
+    switch (level) {
+    case Level::Verbose:
+      return "V";
+    case Level::Debug:
+      return "D";
+    case Level::Info:
+      return "I";
+    case Level::Warn:
+      return "W";
+    }
+    return "?";
+  }
+
+  /**
+   * @brief Record an event, unless its level is filtered out at compile time.
+   */
+  template <Id kId, int kMinLevel = OUTEQUIP_AC_EVENT_LEVEL>
+  void Record(uint32_t now, uint8_t key = 0, uint16_t value = 0) {
+    if constexpr (static_cast<int>(LevelOf(kId)) >= kMinLevel) {
+      Push(Event{now, kId, key, value});
+    }
+  }
+  template <Id kId, int kMinLevel = OUTEQUIP_AC_EVENT_LEVEL>
+  void Record(uint32_t now, ACFramer::Key key, uint16_t value) {
+    Record<kId, kMinLevel>(now, static_cast<uint8_t>(key), value);
+  }
+
+  // Sequence number the next event will get. Events are numbered from 0.
+  uint32_t next_seq() const { return next_seq_; }
+  // Oldest sequence number still held.
+  uint32_t first_seq() const {
+    return next_seq_ > kCapacity ? next_seq_ - kCapacity : 0;
+  }
+  // Events overwritten before anyone read them out.
+  uint32_t num_overwritten() const { return first_seq(); }
+  // Where a reader that has seen everything before since should start. A
+  // since from before a reboot can be past the head; nothing is newer.
+  uint32_t ClampSeq(uint32_t since) const {
+    return since < first_seq() ? first_seq()
+                               : (since > next_seq_ ? next_seq_ : since);
+  }
+
+  /**
+   * @brief Fetch an event by sequence number.
+   *
+   * @return false if it has been overwritten or not recorded yet.
+   */
+  bool Get(uint32_t seq, Event *out) const;
+
+  /**
+   * @brief Render an event's message (without timestamp or level) into buf.
+   *
+   * @return The length written, truncated to fit len.
+   */
+  static size_t Format(const Event &event, char *buf, size_t len);
+
+private:
+  void Push(const Event &event);
+
+  Event events_[kCapacity];
+  uint32_t next_seq_{0};
+};
+
+#endif // __EVENT_LOG_H__
@@ -0,0 +1,38 @@
+#include "hub_scheduler.h"
+
+size_t HubScheduler::AddUnit() {
+  last_start_.push_back(0);
+  started_.push_back(false);
+  return last_start_.size() - 1;
+}
+
+bool HubScheduler::TryStartCycle(size_t unit, uint32_t now) {
+  if (unit >= last_start_.size()) {
+    return false;
+  }
+  const uint32_t since_last = now - last_start_[unit];
+  if (started_[unit] && since_last < period_) {
+    return false;
+  }
+
+  // A unit whose cycles overran its window (slow or missing board) must not
+  // starve, so after two missed periods it may start anywhere.
+  const bool overdue = !started_[unit] || since_last >= 2 * period_;
+  if (!overdue && !InWindow(unit, now)) {
+    return false;
+  }
+
+  started_[unit] = true;
+  last_start_[unit] = now;
+  return true;
+}
+
+bool HubScheduler::InWindow(size_t unit, uint32_t now) const {
+  if (unit >= last_start_.size()) {
+    return false;
+  }
+  // Scale the phase rather than dividing the period, so the remainder of an
+  // uneven split isn't left in no unit's window.
+  const uint64_t phase = now % period_;
+  return phase * last_start_.size() / period_ == unit;
+}
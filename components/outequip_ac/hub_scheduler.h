@@ -0,0 +1,39 @@
+#ifndef __HUB_SCHEDULER_H__
+#define __HUB_SCHEDULER_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Staggers the poll cycles and writes of several units sharing one ESP32.
+//
+// Each period is split into one window per unit. A unit may only begin a poll
+// cycle inside its own window, at most once per period, and only sends
+// commands inside it, so simultaneous commands to several units reach their
+// boards (and the shared supply) a window apart. With a single unit the
+// window is the whole period, so nothing changes.
+class HubScheduler {
+public:
+  explicit HubScheduler(uint32_t period_ms = 1000) : period_(period_ms) {}
+
+  // Returns the new unit's index.
+  size_t AddUnit();
+
+  /**
+   * @brief Whether a unit may begin its next poll cycle now. If so, the cycle
+   * is booked and the unit must wait a full period before the next one.
+   */
+  bool TryStartCycle(size_t unit, uint32_t now);
+  // Whether now falls in the unit's window, so it may send a command.
+  bool InWindow(size_t unit, uint32_t now) const;
+
+  size_t num_units() const { return last_start_.size(); }
+  uint32_t period() const { return period_; }
+
+private:
+  uint32_t period_;
+  std::vector<uint32_t> last_start_;
+  std::vector<bool> started_;
+};
+
+#endif // __HUB_SCHEDULER_H__
@@ -0,0 +1,87 @@
+#include "link_benchmark.h"
+
+#include <algorithm>
+
+void LinkBenchmark::Start(uint32_t now, uint32_t duration_ms,
+                          const Counters &counters) {
+  running_ = true;
+  started_at_ = now;
+  duration_ = duration_ms;
+  start_counters_ = counters;
+  in_flight_ = false;
+  timeouts_ = 0;
+  replies_ = 0;
+  rtt_max_ = 0;
+  std::fill(rtt_bins_, rtt_bins_ + kNumBins, 0);
+  rtt_overflow_ = 0;
+}
+
+bool LinkBenchmark::ShouldSend(uint32_t now) {
+  if (!in_flight_) {
+    return true;
+  }
+  if (now - sent_at_ < reply_timeout_) {
+    return false;
+  }
+  timeouts_++;
+  in_flight_ = false;
+  return true;
+}
+
+void LinkBenchmark::OnSent(uint32_t now) {
+  in_flight_ = true;
+  sent_at_ = now;
+}
+
+void LinkBenchmark::OnReply(uint32_t now) {
+  if (!in_flight_) {
+    return;
+  }
+  in_flight_ = false;
+  const uint32_t rtt = now - sent_at_;
+  if (rtt < kNumBins) {
+    rtt_bins_[rtt]++;
+  } else {
+    rtt_overflow_++;
+  }
+  rtt_max_ = std::max(rtt_max_, rtt);
+  replies_++;
+}
+
+float LinkBenchmark::Percentile(float fraction) const {
+  if (replies_ == 0) {
+    return 0;
+  }
+  // The smallest RTT at or below which at least fraction of replies fall.
+  const uint32_t rank = std::max<uint32_t>(1, fraction * replies_ + 0.5f);
+  uint32_t seen = 0;
+  for (size_t i = 0; i < kNumBins; ++i) {
+    seen += rtt_bins_[i];
+    if (seen >= rank) {
+      return i;
+    }
+  }
+  return rtt_max_;
+}
+
+LinkBenchmark::Result LinkBenchmark::Finish(uint32_t now,
+                                            const Counters &counters) {
+  running_ = false;
+  in_flight_ = false;
+
+  Result result{};
+  const uint32_t elapsed = now - started_at_;
+  const uint32_t rx = counters.frames_rx - start_counters_.frames_rx;
+  const uint32_t failed = counters.frames_failed - start_counters_.frames_failed;
+  result.frame_rate = elapsed > 0 ? replies_ * 1000.0f / elapsed : 0;
+  result.rtt_median_ms = Percentile(0.5f);
+  result.rtt_p95_ms = Percentile(0.95f);
+  result.rtt_max_ms = rtt_max_;
+  result.failure_rate = rx + failed > 0 ? failed * 100.0f / (rx + failed) : 0;
+  result.spurious_bytes =
+      counters.spurious_bytes_rx - start_counters_.spurious_bytes_rx;
+  result.timeouts = timeouts_;
+  result.replies = replies_;
+  result.slow_replies = rtt_overflow_;
+  return result;
+}
@@ -0,0 +1,78 @@
+#ifndef __LINK_BENCHMARK_H__
+#define __LINK_BENCHMARK_H__
+
+#include <cstddef>
+#include <cstdint>
+
+// Measures how fast and how cleanly the board link runs flat out.
+//
+// The caller keeps exactly one frame in flight: it sends whenever
+// ShouldSend() says so and reports each reply. Round trip times go into a
+// fixed 1 ms histogram so a long run costs no extra memory; slower replies
+// are counted in an overflow bucket rather than folded into it. Frame, checksum
+// and spurious byte counts come from the caller's own counters, sampled at
+// Start() and Finish().
+class LinkBenchmark {
+public:
+  struct Counters {
+    uint32_t frames_rx;
+    uint32_t frames_failed;
+    uint32_t spurious_bytes_rx;
+  };
+
+  struct Result {
+    // Replies per second over the whole run.
+    float frame_rate;
+    float rtt_median_ms;
+    float rtt_p95_ms;
+    float rtt_max_ms;
+    // Failed frames as a percentage of all frames received.
+    float failure_rate;
+    uint32_t spurious_bytes;
+    uint32_t timeouts;
+    uint32_t replies;
+    // Replies too slow for the histogram. A percentile that lands among them
+    // is reported as rtt_max_ms, the only such RTT known exactly.
+    uint32_t slow_replies;
+  };
+
+  // Replies slower than this count as timeouts and the frame is resent.
+  explicit LinkBenchmark(uint32_t reply_timeout_ms = 250)
+      : reply_timeout_(reply_timeout_ms) {}
+
+  void Start(uint32_t now, uint32_t duration_ms, const Counters &counters);
+  bool running() const { return running_; }
+  // Whether the run's duration is up; the caller should then Finish().
+  bool Expired(uint32_t now) const { return now - started_at_ >= duration_; }
+
+  /**
+   * @brief Whether the next frame should go out now: nothing is in flight,
+   * or the frame in flight has timed out (which is counted).
+   */
+  bool ShouldSend(uint32_t now);
+  void OnSent(uint32_t now);
+  void OnReply(uint32_t now);
+
+  Result Finish(uint32_t now, const Counters &counters);
+
+private:
+  // One bin per millisecond; slower replies go to rtt_overflow_.
+  static const size_t kNumBins = 128;
+
+  float Percentile(float fraction) const;
+
+  uint32_t reply_timeout_;
+  bool running_{false};
+  uint32_t started_at_{0};
+  uint32_t duration_{0};
+  Counters start_counters_{};
+  bool in_flight_{false};
+  uint32_t sent_at_{0};
+  uint32_t timeouts_{0};
+  uint32_t replies_{0};
+  uint32_t rtt_max_{0};
+  uint32_t rtt_bins_[kNumBins] = {};
+  uint32_t rtt_overflow_{0};
+};
+
+#endif // __LINK_BENCHMARK_H__
@@ -2,11 +2,42 @@
 #include "esphome/core/helpers.h"
 #include "esphome/core/log.h"
 #include "esphome/core/preferences.h"
+#include <cinttypes>
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 
 namespace esphome {
 namespace outequip_ac {
 
+namespace {
+
+const char *ClimateModeToString(climate::ClimateMode mode) {
+  switch (mode) {
+  case climate::CLIMATE_MODE_COOL:
+    return "cool";
+  case climate::CLIMATE_MODE_HEAT:
+    return "heat";
+  case climate::CLIMATE_MODE_FAN_ONLY:
+    return "fan_only";
+  default:
+    return "off";
+  }
+}
+
+const char *ClimateFanModeToString(climate::ClimateFanMode fan_mode) {
+  switch (fan_mode) {
+  case climate::CLIMATE_FAN_LOW:
+    return "low";
+  case climate::CLIMATE_FAN_MEDIUM:
+    return "medium";
+  default:
+    return "high";
+  }
+}
+
+} // namespace
+
 void OutEquipACSwitch::write_state(bool state) {
   if (parent_ != nullptr) {
     switch (type_) {
@@ -34,221 +65,373 @@ void OutEquipACSwitch::setup() {
   }
 }
 
+#ifdef USE_OUTEQUIP_AC_BENCHMARK
+void OutEquipACBenchmarkButton::press_action() {
+  if (parent_ != nullptr) {
+    parent_->StartBenchmark();
+  }
+}
+#endif
+
 void OutEquipAC::set_lcd_state(bool state) {
-  ESP_LOGD("outequip_ac", "Setting LCD state to %s", state ? "ON" : "OFF");
   EnqueueFrame(ACFramer::Key::LCD,
                state ? static_cast<uint16_t>(ACFramer::OnOffValue::On)
                      : static_cast<uint16_t>(ACFramer::OnOffValue::Off));
+#ifdef USE_OUTEQUIP_AC_LCD_SWITCH
   if (lcd_switch_ != nullptr) {
     lcd_switch_->publish_state(state);
   }
+#endif
 }
 
 void OutEquipAC::set_swing_state(bool state) {
-  ESP_LOGD("outequip_ac", "Setting Swing state to %s", state ? "ON" : "OFF");
   EnqueueFrame(ACFramer::Key::Swing,
                state ? static_cast<uint16_t>(ACFramer::OnOffValue::On)
                      : static_cast<uint16_t>(ACFramer::OnOffValue::Off));
 }
 
 void OutEquipAC::set_light_state(bool state) {
-  ESP_LOGD("outequip_ac", "Setting Light state to %s", state ? "ON" : "OFF");
   EnqueueFrame(ACFramer::Key::Light,
                state ? static_cast<uint16_t>(ACFramer::LightValue::On)
                      : static_cast<uint16_t>(ACFramer::LightValue::Off));
+#ifdef USE_OUTEQUIP_AC_LIGHT_SWITCH
   if (light_switch_ != nullptr) {
     light_switch_->publish_state(state);
     light_switch_->set_has_state(true);
   }
+#endif
 }
 
 void OutEquipAC::setup() {
-  EnqueueFrame(ACFramer::Key::Active, 0);
+  journal_ = StateJournal(random_uint32());
+  rules_.set_action_fn(
+      [this](size_t rule, bool cleared, const RuleEngine::Action &action) {
+        ApplyRuleAction(rule, cleared, action);
+      });
+  hub_index_ = OutEquipACHub::get()->AddUnit(this);
+#ifdef USE_OUTEQUIP_AC_TELEMETRY
+  // Telemetry needs time_id, so USE_OUTEQUIP_AC_TIME is defined too.
+  if (telemetry_buffer_size_ > 0) {
+    OutEquipACHub::get()->SetupTelemetry(telemetry_buffer_size_,
+                                         telemetry_flash_blocks_,
+                                         telemetry_max_packet_size_, time_,
+                                         telemetry_confirm_delivery_);
+  }
+#endif
+#ifdef USE_WEBSERVER
+  if (web_server_base::global_web_server_base != nullptr) {
+    web_server_base::global_web_server_base->init();
+    // One handler of each serves every unit.
+    if (hub_index_ == 0) {
+      web_server_base::global_web_server_base->add_handler(
+          new OutEquipACStateHandler());
+      web_server_base::global_web_server_base->add_handler(
+          new OutEquipACLogHandler());
+    }
+    if (asset_handler_ != nullptr) {
+      web_server_base::global_web_server_base->add_handler(asset_handler_);
+    }
+  }
+#endif
+  if (passthrough_uart_ != nullptr) {
+    arbiter_ = new PassthroughArbiter(
+        [this](const uint8_t *data, size_t len) {
+          this->write_array(data, len);
+        },
+        [this](const uint8_t *data, size_t len) {
+          passthrough_uart_->write_array(data, len);
+        },
+        [this](const ACFramer &frame, bool local) {
+          HandleFrame(frame, local);
+        });
+    arbiter_->set_on_board_error(
+        [this](uint8_t c, size_t frame_len) { HandleRxError(c, frame_len); });
+  } else {
+    EnqueueFrame(ACFramer::Key::Active, 0);
+  }
   last_frame_sent = millis();
 }
 
 void OutEquipAC::loop() {
-  if (millis() - last_frame_sent >= 1000) {
+  if (log_events_) {
+    DrainEventsToLog();
+  }
+  // Scene frames held back by a benchmark haven't been sent yet.
+  if (scenes_.HasPending() && !Benchmarking() &&
+      millis() - scene_sent_at_ >= kSceneTimeoutMs) {
+    scenes_.ClearPending();
+    if (scene_reporting_) {
+      CompleteScene(false);
+    }
+  }
+#ifdef USE_OUTEQUIP_AC_TIME
+  // Schedule rules only care about the minute; the engine ignores repeats.
+  if (time_ != nullptr && millis() - last_clock_check_ >= 1000) {
+    last_clock_check_ = millis();
+    auto now = time_->now();
+    if (now.is_valid()) {
+      rules_.SetInput(RuleEngine::Input::MinuteOfDay,
+                      now.hour * 60 + now.minute);
+    }
+  }
+#endif
+  if (arbiter_ != nullptr) {
+    uint8_t c;
+    while (passthrough_uart_->available() && passthrough_uart_->read_byte(&c)) {
+      arbiter_->OnModuleByte(c, millis());
+    }
+    while (this->available()) {
+      arbiter_->OnBoardByte(this->read(), millis());
+    }
+    arbiter_->Poll(millis());
+    // The arbiter decides whether the board is free.
     MaybeSendCurFrame();
+    return;
   }
 
-  auto publish_sensor = [](sensor::Sensor *sensor, float value) {
-    if (sensor != nullptr && (!sensor->has_state() || sensor->state != value)) {
-      ESP_LOGD("outequip_ac", "Publishing sensor state for '%s': %.1f",
-               sensor->get_name().c_str(), value);
-      sensor->publish_state(value);
-    }
-  };
+  const bool benchmarking = Benchmarking();
+  if (benchmarking) {
+#ifdef USE_OUTEQUIP_AC_BENCHMARK
+    StepBenchmark();
+#endif
+  } else if (millis() - last_frame_sent >= 1000 ||
+             (!txQueue.empty() && !expecting_key.has_value())) {
+    // A command waiting for its window goes as soon as the window opens.
+    MaybeSendCurFrame();
+  }
 
   while (this->available()) {
     uint8_t c = this->read();
     if (!rxFramer.FrameData(c)) {
-      if (rxFramer.buffer_pos() > 0) {
-        num_frames_failed_++;
-      } else {
-        num_spurious_bytes_rx_++;
-      }
+      HandleRxError(c, rxFramer.buffer_pos());
       rxFramer.Reset();
     } else if (rxFramer.HasFullFrame()) {
-      num_frames_rx_++;
-      const auto key = rxFramer.GetKey();
-      const auto value = rxFramer.GetValue();
-
-      bool climate_changed = false;
-
-      switch (key) {
-      case ACFramer::Key::Power: {
-        const auto old_power_state = cur_power_state_;
-        cur_power_state_ = static_cast<ACFramer::OnOffValue>(value);
-        if (lcd_switch_ != nullptr) {
-          if (cur_power_state_ == ACFramer::OnOffValue::Off) {
-            lcd_switch_->publish_state(false);
-            lcd_switch_->set_has_state(true);
-          } else if (old_power_state == ACFramer::OnOffValue::Off &&
-                     cur_power_state_ == ACFramer::OnOffValue::On) {
-            lcd_switch_->publish_state(true);
-            lcd_switch_->set_has_state(true);
-          }
-        }
-        break;
+      HandleFrame(rxFramer, true);
+      rxFramer.Reset();
+      if (benchmarking) {
+#ifdef USE_OUTEQUIP_AC_BENCHMARK
+        StepBenchmark();
+#endif
+      } else {
+        MaybeSendCurFrame();
       }
-      case ACFramer::Key::Mode:
-        cur_mode_ = static_cast<ACFramer::ModeValue>(value);
-        break;
-      case ACFramer::Key::SetTemperature: {
-        float new_target = (value - 32.0f) * 5.0f / 9.0f;
-        if (this->target_temperature != new_target) {
-          ESP_LOGD("outequip_ac", "Climate target temp changed to %.1f C",
-                   new_target);
-          this->target_temperature = new_target;
-          climate_changed = true;
-        }
-        break;
+    }
+  }
+}
+
+void OutEquipAC::HandleRxError(uint8_t c, size_t frame_len) {
+  if (frame_len > 0) {
+    events_.Record<EventLog::Id::FrameFailed>(millis(), 0, frame_len);
+    num_frames_failed_++;
+  } else {
+    events_.Record<EventLog::Id::SpuriousByte>(millis(), c);
+    num_spurious_bytes_rx_++;
+  }
+}
+
+void OutEquipAC::HandleFrame(const ACFramer &frame, bool local) {
+  [[maybe_unused]] auto publish_sensor = [](sensor::Sensor *sensor,
+                                            float value) {
+    if (sensor != nullptr && (!sensor->has_state() || sensor->state != value)) {
+      sensor->publish_state(value);
+    }
+  };
+
+  num_frames_rx_++;
+  const auto key = frame.GetKey();
+  const auto value = frame.GetValue();
+  const size_t key_idx = QueryKeyIndex(key);
+  events_.Record<EventLog::Id::FrameRx>(millis(), key, value);
+  if (key_idx < kNumQueryKeys && last_values_[key_idx] != value) {
+    last_values_[key_idx] = value;
+    events_.Record<EventLog::Id::StateChanged>(millis(), key, value);
+  }
+
+  bool climate_changed = false;
+
+  switch (key) {
+  case ACFramer::Key::Power: {
+    [[maybe_unused]] const auto old_power_state = cur_power_state_;
+    cur_power_state_ = static_cast<ACFramer::OnOffValue>(value);
+#ifdef USE_OUTEQUIP_AC_LCD_SWITCH
+    if (lcd_switch_ != nullptr) {
+      if (cur_power_state_ == ACFramer::OnOffValue::Off) {
+        lcd_switch_->publish_state(false);
+        lcd_switch_->set_has_state(true);
+      } else if (old_power_state == ACFramer::OnOffValue::Off &&
+                 cur_power_state_ == ACFramer::OnOffValue::On) {
+        lcd_switch_->publish_state(true);
+        lcd_switch_->set_has_state(true);
       }
-      case ACFramer::Key::FanSpeed:
-        cur_fan_speed_ = value;
-        climate::ClimateFanMode new_fan_mode;
-        if (value <= 1)
-          new_fan_mode = climate::CLIMATE_FAN_LOW;
-        else if (value <= 3)
-          new_fan_mode = climate::CLIMATE_FAN_MEDIUM;
-        else
-          new_fan_mode = climate::CLIMATE_FAN_HIGH;
-        if (!this->fan_mode.has_value() ||
-            this->fan_mode.value() != new_fan_mode) {
-          ESP_LOGD("outequip_ac", "Climate fan speed changed to %d",
-                   static_cast<int>(new_fan_mode));
-          this->fan_mode = new_fan_mode;
-          climate_changed = true;
-        }
-        break;
-      case ACFramer::Key::UndervoltProtect:
-        publish_sensor(undervolt_sensor_, value / 10.0f);
-        break;
-      case ACFramer::Key::OvervoltProtect:
-        publish_sensor(overvolt_sensor_, value);
-        break;
-      case ACFramer::Key::IntakeAirTemp: {
-        int8_t intake_temp = static_cast<int8_t>(value & 0xFF);
-        publish_sensor(intake_temp_sensor_, intake_temp);
-        if (this->current_temperature != intake_temp) {
-          ESP_LOGD("outequip_ac", "Climate current temp changed to %d C",
-                   intake_temp);
-          this->current_temperature = intake_temp;
-          climate_changed = true;
-        }
-        break;
+    }
+#endif
+    break;
+  }
+  case ACFramer::Key::Mode:
+    cur_mode_ = static_cast<ACFramer::ModeValue>(value);
+    break;
+  case ACFramer::Key::SetTemperature: {
+    float new_target = (value - 32.0f) * 5.0f / 9.0f;
+    if (this->target_temperature != new_target) {
+      this->target_temperature = new_target;
+      climate_changed = true;
+    }
+    break;
+  }
+  case ACFramer::Key::FanSpeed:
+    cur_fan_speed_ = value;
+    climate::ClimateFanMode new_fan_mode;
+    if (value <= 1)
+      new_fan_mode = climate::CLIMATE_FAN_LOW;
+    else if (value <= 3)
+      new_fan_mode = climate::CLIMATE_FAN_MEDIUM;
+    else
+      new_fan_mode = climate::CLIMATE_FAN_HIGH;
+    if (!this->fan_mode.has_value() ||
+        this->fan_mode.value() != new_fan_mode) {
+      this->fan_mode = new_fan_mode;
+      climate_changed = true;
+    }
+    break;
+#ifdef USE_OUTEQUIP_AC_UNDERVOLT_SENSOR
+  case ACFramer::Key::UndervoltProtect:
+    publish_sensor(undervolt_sensor_, value / 10.0f);
+    break;
+#endif
+#ifdef USE_OUTEQUIP_AC_OVERVOLT_SENSOR
+  case ACFramer::Key::OvervoltProtect:
+    publish_sensor(overvolt_sensor_, value);
+    break;
+#endif
+  case ACFramer::Key::IntakeAirTemp: {
+    int8_t intake_temp = static_cast<int8_t>(value & 0xFF);
+#ifdef USE_OUTEQUIP_AC_INTAKE_TEMP_SENSOR
+    publish_sensor(intake_temp_sensor_, intake_temp);
+#endif
+    journal_.Set(StateJournal::Field::IntakeTemp, intake_temp);
+    rules_.SetInput(RuleEngine::Input::IntakeTemp, intake_temp);
+    if (this->current_temperature != intake_temp) {
+      this->current_temperature = intake_temp;
+      climate_changed = true;
+    }
+    break;
+  }
+#ifdef USE_OUTEQUIP_AC_OUTLET_TEMP_SENSOR
+  case ACFramer::Key::OutletAirTemp: {
+    int8_t outlet_temp = static_cast<int8_t>(value & 0xFF);
+    publish_sensor(outlet_temp_sensor_, outlet_temp);
+    journal_.Set(StateJournal::Field::OutletTemp, outlet_temp);
+    break;
+  }
+#endif
+#if defined(USE_OUTEQUIP_AC_VOLTAGE_SENSOR) ||                               \
+    defined(USE_OUTEQUIP_AC_VOLTAGE_RULES)
+  case ACFramer::Key::Voltage:
+#ifdef USE_OUTEQUIP_AC_VOLTAGE_SENSOR
+    publish_sensor(voltage_sensor_, value / 10.0f);
+#endif
+    rules_.SetInput(RuleEngine::Input::Voltage, value / 10.0f);
+    break;
+#endif
+#ifdef USE_OUTEQUIP_AC_LCD_SWITCH
+  case ACFramer::Key::LCD:
+    if (lcd_switch_ != nullptr &&
+        cur_power_state_ == ACFramer::OnOffValue::On) {
+      // A serial-interface reported value of 1 is off and 0 is on
+      bool is_on = (value == 0);
+      if (!lcd_switch_->has_state() || lcd_switch_->state != is_on) {
+        lcd_switch_->publish_state(is_on);
+        lcd_switch_->set_has_state(true);
       }
-      case ACFramer::Key::OutletAirTemp:
-        publish_sensor(outlet_temp_sensor_, static_cast<int8_t>(value & 0xFF));
-        break;
-      case ACFramer::Key::Voltage:
-        publish_sensor(voltage_sensor_, value / 10.0f);
-        break;
-      case ACFramer::Key::LCD:
-        if (lcd_switch_ != nullptr &&
-            cur_power_state_ == ACFramer::OnOffValue::On) {
-          // A serial-interface reported value of 1 is off and 0 is on
-          bool is_on = (value == 0);
-          if (!lcd_switch_->has_state() || lcd_switch_->state != is_on) {
-            ESP_LOGD("outequip_ac", "LCD switch state changed to %s",
-                     is_on ? "ON" : "OFF");
-            lcd_switch_->publish_state(is_on);
-            lcd_switch_->set_has_state(true);
-          }
-        }
-        break;
-      case ACFramer::Key::Swing:
-        if (swing_switch_ != nullptr) {
-          bool is_on =
-              (value == static_cast<uint16_t>(ACFramer::OnOffValue::On));
-          if (!swing_switch_->has_state() || swing_switch_->state != is_on) {
-            ESP_LOGD("outequip_ac", "Swing switch state changed to %s",
-                     is_on ? "ON" : "OFF");
-            swing_switch_->publish_state(is_on);
-            swing_switch_->set_has_state(true);
-          }
-        }
+    }
+    break;
+#endif
+#ifdef USE_OUTEQUIP_AC_SWING_SWITCH
+  case ACFramer::Key::Swing:
+    if (swing_switch_ != nullptr) {
+      bool is_on =
+          (value == static_cast<uint16_t>(ACFramer::OnOffValue::On));
+      if (!swing_switch_->has_state() || swing_switch_->state != is_on) {
+        swing_switch_->publish_state(is_on);
+        swing_switch_->set_has_state(true);
+      }
+    }
+    break;
+#endif
+#ifdef USE_OUTEQUIP_AC_AMPERAGE_SENSOR
+  case ACFramer::Key::Amperage:
+    publish_sensor(amperage_sensor_, value);
+    break;
+#endif
+  case ACFramer::Key::Light:
+    // Ignore reading Light value over serial since the Summit2 firmware is
+    // buggy.
+    break;
+  case ACFramer::Key::Active:
+    // When passing through, the app runs its own handshake.
+    if (local && value == 2)
+      EnqueueFrame(ACFramer::Key::Active, 1);
+    break;
+  default:
+    // Keys for entities that aren't configured are never polled.
+    break;
+  }
+
+  // Handle Power/Mode combination for Climate
+  if (key == ACFramer::Key::Power || key == ACFramer::Key::Mode) {
+    climate::ClimateMode new_mode = climate::CLIMATE_MODE_OFF;
+    if (cur_power_state_ == ACFramer::OnOffValue::On) {
+      switch (cur_mode_) {
+      case ACFramer::ModeValue::Cool:
+      case ACFramer::ModeValue::Eco:
+      case ACFramer::ModeValue::Sleep:
+      case ACFramer::ModeValue::Turbo:
+        new_mode = climate::CLIMATE_MODE_COOL;
         break;
-      case ACFramer::Key::Amperage:
-        publish_sensor(amperage_sensor_, value);
+      case ACFramer::ModeValue::Heat:
+        new_mode = climate::CLIMATE_MODE_HEAT;
         break;
-      case ACFramer::Key::Light:
-        // Ignore reading Light value over serial since the Summit2 firmware is
-        // buggy.
+      case ACFramer::ModeValue::Fan:
+        new_mode = climate::CLIMATE_MODE_FAN_ONLY;
         break;
-      case ACFramer::Key::Active:
-        if (value == 2)
-          EnqueueFrame(ACFramer::Key::Active, 1);
+      default:
         break;
       }
+    }
+    if (this->mode != new_mode) {
+      this->mode = new_mode;
+      climate_changed = true;
+    }
+  }
 
-      // Handle Power/Mode combination for Climate
-      if (key == ACFramer::Key::Power || key == ACFramer::Key::Mode) {
-        climate::ClimateMode new_mode = climate::CLIMATE_MODE_OFF;
-        if (cur_power_state_ == ACFramer::OnOffValue::On) {
-          switch (cur_mode_) {
-          case ACFramer::ModeValue::Cool:
-          case ACFramer::ModeValue::Eco:
-          case ACFramer::ModeValue::Sleep:
-          case ACFramer::ModeValue::Turbo:
-            new_mode = climate::CLIMATE_MODE_COOL;
-            break;
-          case ACFramer::ModeValue::Heat:
-            new_mode = climate::CLIMATE_MODE_HEAT;
-            break;
-          case ACFramer::ModeValue::Fan:
-            new_mode = climate::CLIMATE_MODE_FAN_ONLY;
-            break;
-          default:
-            break;
-          }
-        }
-        if (this->mode != new_mode) {
-          ESP_LOGD("outequip_ac", "Climate mode changed to %d",
-                   static_cast<int>(new_mode));
-          this->mode = new_mode;
-          climate_changed = true;
-        }
-      }
+  UpdateClimateJournal();
+  if (climate_changed) {
+    this->publish_state();
+  }
 
-      if (climate_changed) {
-        this->publish_state();
-      }
+  scenes_.OnBoardValue(key, value);
+  if (scene_reporting_ && !scenes_.HasPending()) {
+    CompleteScene(true);
+  }
 
-      // Check response expecting
-      if (expecting_key.has_value() && *expecting_key == key) {
-        expecting_key.reset();
-        if (key == kQueryKeys[cur_query_key_idx]) {
-          if (++cur_query_key_idx >= sizeof(kQueryKeys) / sizeof(*kQueryKeys)) {
-            cur_query_key_idx = 0;
-            last_full_status = millis();
-          }
-        }
-      }
+  if (!local) {
+    // Snooped from the app's traffic; no need to poll this key ourselves.
+    if (key_idx < kNumQueryKeys) {
+      snooped_at_[key_idx] = millis();
+    }
+    return;
+  }
 
-      rxFramer.Reset();
-      MaybeSendCurFrame();
+  // Check response expecting
+  if (expecting_key.has_value() && *expecting_key == key) {
+    expecting_key.reset();
+#ifdef USE_OUTEQUIP_AC_BENCHMARK
+    if (benchmark_.running()) {
+      benchmark_.OnReply(millis());
+    }
+#endif
+    if (key == kQueryKeys[cur_query_key_idx]) {
+      AdvanceQueryKey();
     }
   }
 }
@@ -262,81 +445,708 @@ climate::ClimateTraits OutEquipAC::traits() {
   traits.set_supported_fan_modes({climate::CLIMATE_FAN_LOW,
                                   climate::CLIMATE_FAN_MEDIUM,
                                   climate::CLIMATE_FAN_HIGH});
+  // The board takes 61-86°F (see protocol.md).
+  traits.set_visual_min_temperature(16.0f);
+  traits.set_visual_max_temperature(30.0f);
   return traits;
 }
 
 void OutEquipAC::control(const climate::ClimateCall &call) {
-  if (call.get_mode().has_value()) {
-    auto m = *call.get_mode();
-    if (m == climate::CLIMATE_MODE_OFF) {
-      EnqueueFrame(ACFramer::Key::Mode, 1);
-      EnqueueFrame(ACFramer::Key::Power, 1);
-    } else {
-      uint16_t ac_mode = 0;
-      if (m == climate::CLIMATE_MODE_COOL)
-        ac_mode = 1;
-      else if (m == climate::CLIMATE_MODE_HEAT)
-        ac_mode = 2;
-      else if (m == climate::CLIMATE_MODE_FAN_ONLY)
-        ac_mode = 3;
+  ScenePlanner::Scene scene;
+  if (call.get_mode().has_value())
+    AddClimateMode(scene, *call.get_mode());
+  if (call.get_target_temperature().has_value())
+    AddTargetTemperature(scene, *call.get_target_temperature());
+  if (call.get_fan_mode().has_value())
+    AddFanMode(scene, *call.get_fan_mode());
+  ApplyScene(scene, false);
+}
+
+void OutEquipAC::AddClimateMode(ScenePlanner::Scene &scene,
+                                climate::ClimateMode mode) {
+  if (mode == climate::CLIMATE_MODE_OFF) {
+    scene.Set(ACFramer::Key::Mode, 1);
+    scene.Set(ACFramer::Key::Power, 1);
+    return;
+  }
+  uint16_t ac_mode = 0;
+  if (mode == climate::CLIMATE_MODE_COOL)
+    ac_mode = 1;
+  else if (mode == climate::CLIMATE_MODE_HEAT)
+    ac_mode = 2;
+  else if (mode == climate::CLIMATE_MODE_FAN_ONLY)
+    ac_mode = 3;
+
+  if (ac_mode != 0)
+    scene.Set(ACFramer::Key::Mode, ac_mode);
+  scene.Set(ACFramer::Key::Power, 2);
+}
+
+void OutEquipAC::AddTargetTemperature(ScenePlanner::Scene &scene,
+                                      float target_temperature) {
+  // ESPHome provides target temperature in Celsius, convert to Fahrenheit
+  // for the board
+  float fahrenheit = (target_temperature * 9.0f / 5.0f) + 32.0f;
+  scene.Set(ACFramer::Key::SetTemperature,
+            static_cast<uint16_t>(std::round(fahrenheit)));
+}
+
+void OutEquipAC::AddFanMode(ScenePlanner::Scene &scene,
+                            climate::ClimateFanMode fan_mode) {
+  uint16_t speed = 3;
+  if (fan_mode == climate::CLIMATE_FAN_LOW)
+    speed = 1;
+  else if (fan_mode == climate::CLIMATE_FAN_MEDIUM)
+    speed = 3;
+  else if (fan_mode == climate::CLIMATE_FAN_HIGH)
+    speed = 5;
+  scene.Set(ACFramer::Key::FanSpeed, speed);
+}
 
-      if (ac_mode != 0)
-        EnqueueFrame(ACFramer::Key::Mode, ac_mode);
-      EnqueueFrame(ACFramer::Key::Power, 2);
+void OutEquipAC::AddLcd(ScenePlanner::Scene &scene, bool on) {
+  scene.Set(ACFramer::Key::LCD,
+            on ? static_cast<uint16_t>(ACFramer::OnOffValue::On)
+               : static_cast<uint16_t>(ACFramer::OnOffValue::Off));
+}
+
+void OutEquipAC::AddLight(ScenePlanner::Scene &scene, bool on) {
+  scene.Set(ACFramer::Key::Light,
+            on ? static_cast<uint16_t>(ACFramer::LightValue::On)
+               : static_cast<uint16_t>(ACFramer::LightValue::Off));
+}
+
+void OutEquipAC::ApplyScene(const ScenePlanner::Scene &scene, bool report) {
+  // Scenes from automations and API actions bypass the climate call's
+  // checks; a Fahrenheit value taken as Celsius mustn't reach the board.
+  ScenePlanner::Scene checked = scene;
+  const auto temp = scene.Get(ACFramer::Key::SetTemperature);
+  if (temp.has_value()) {
+    auto traits = this->get_traits();
+    const float celsius = (*temp - 32.0f) * 5.0f / 9.0f;
+    // The board value is rounded to whole °F.
+    if (celsius < traits.get_visual_min_temperature() - 0.5f ||
+        celsius > traits.get_visual_max_temperature() + 0.5f) {
+      ESP_LOGW("outequip_ac",
+               "Ignoring scene target temperature %.1f°C, outside %.0f-%.0f°C",
+               celsius, traits.get_visual_min_temperature(),
+               traits.get_visual_max_temperature());
+      checked.Clear(ACFramer::Key::SetTemperature);
+    }
+  }
+  const auto steps = scenes_.Plan(checked);
+  for (const auto &step : steps) {
+    EnqueueFrame(step.key, step.value);
+  }
+  if (!steps.empty()) {
+    scene_sent_at_ = millis();
+  }
+
+  // The display and light switches are optimistic, as in set_lcd_state()
+  // and set_light_state().
+#ifdef USE_OUTEQUIP_AC_LCD_SWITCH
+  const auto lcd = scene.Get(ACFramer::Key::LCD);
+  if (lcd.has_value() && lcd_switch_ != nullptr) {
+    lcd_switch_->publish_state(
+        *lcd == static_cast<uint16_t>(ACFramer::OnOffValue::On));
+  }
+#endif
+#ifdef USE_OUTEQUIP_AC_LIGHT_SWITCH
+  const auto light = scene.Get(ACFramer::Key::Light);
+  if (light.has_value() && light_switch_ != nullptr) {
+    light_switch_->publish_state(
+        *light == static_cast<uint16_t>(ACFramer::LightValue::On));
+    light_switch_->set_has_state(true);
+  }
+#endif
+
+  if (report) {
+    scene_reporting_ = true;
+    if (!scenes_.HasPending()) {
+      CompleteScene(true);
     }
   }
+}
+
+void OutEquipAC::CompleteScene(bool success) {
+  scene_reporting_ = false;
+  scene_complete_callback_.call(success);
+}
 
-  if (call.get_target_temperature().has_value()) {
-    // ESPHome provides target temperature in Celsius, convert to Fahrenheit
-    // for the board
-    float fahrenheit = (*call.get_target_temperature() * 9.0f / 5.0f) + 32.0f;
-    EnqueueFrame(ACFramer::Key::SetTemperature,
-                 static_cast<uint16_t>(std::round(fahrenheit)));
+void OutEquipAC::ApplyRuleAction(size_t rule, bool cleared,
+                                 const RuleEngine::Action &action) {
+  events_.Record<EventLog::Id::RuleFired>(millis(), rule, cleared);
+#ifdef USE_OUTEQUIP_AC_BENCHMARK
+  // Rules protect the unit; their commands can't wait out a benchmark.
+  if (Benchmarking()) {
+    ESP_LOGW("outequip_ac", "Link benchmark aborted: rule %u fired",
+             static_cast<unsigned>(rule));
+    StopBenchmark();
   }
+#endif
+  // Straight to control(), and so to the frame queue; the values were
+  // validated at compile time.
+  auto call = this->make_call();
+  if (action.mode >= 0) {
+    call.set_mode(static_cast<climate::ClimateMode>(action.mode));
+  }
+  if (!std::isnan(action.target_temperature)) {
+    call.set_target_temperature(action.target_temperature);
+  }
+  if (action.fan_mode >= 0) {
+    call.set_fan_mode(static_cast<climate::ClimateFanMode>(action.fan_mode));
+  }
+  control(call);
+}
 
-  if (call.get_fan_mode().has_value()) {
-    auto fm = *call.get_fan_mode();
-    uint16_t speed = 3;
-    if (fm == climate::CLIMATE_FAN_LOW)
-      speed = 1;
-    else if (fm == climate::CLIMATE_FAN_MEDIUM)
-      speed = 3;
-    else if (fm == climate::CLIMATE_FAN_HIGH)
-      speed = 5;
-    EnqueueFrame(ACFramer::Key::FanSpeed, speed);
+void OutEquipAC::UpdateClimateJournal() {
+  journal_.Set(StateJournal::Field::Mode, this->mode);
+  if (this->fan_mode.has_value()) {
+    journal_.Set(StateJournal::Field::FanMode, *this->fan_mode);
+  }
+  if (!std::isnan(this->target_temperature)) {
+    journal_.Set(StateJournal::Field::TargetTemp, this->target_temperature);
   }
 }
 
+std::string OutEquipAC::BuildStateJson(uint32_t epoch, uint32_t since) {
+  const bool full = !journal_.CanServeDelta(epoch, since);
+  std::string json;
+  json.reserve(256);
+  char buf[64];
+
+  snprintf(buf, sizeof(buf),
+           "{\"epoch\":%" PRIu32 ",\"v\":%" PRIu32 ",\"full\":%s",
+           journal_.epoch(), journal_.version(), full ? "true" : "false");
+  json += buf;
+
+  if (full) {
+    auto traits = this->get_traits();
+    json += ",\"name\":\"";
+    json += this->get_name().c_str();
+    json += "\"";
+    if (unit_name_ != nullptr) {
+      json += ",\"unit\":\"";
+      json += unit_name_;
+      json += "\"";
+    }
+    snprintf(buf, sizeof(buf), ",\"min_temp\":%.1f,\"max_temp\":%.1f",
+             traits.get_visual_min_temperature(),
+             traits.get_visual_max_temperature());
+    json += buf;
+  }
+
+  for (size_t i = 0; i < StateJournal::kNumFields; ++i) {
+    const auto f = static_cast<StateJournal::Field>(i);
+    if (full ? !journal_.Has(f) : !journal_.ChangedSince(f, since)) {
+      continue;
+    }
+    const float v = journal_.Get(f);
+    switch (f) {
+    case StateJournal::Field::Mode:
+      snprintf(buf, sizeof(buf), ",\"%s\":\"%s\"",
+               StateJournal::FieldToString(f),
+               ClimateModeToString(static_cast<climate::ClimateMode>(v)));
+      break;
+    case StateJournal::Field::FanMode:
+      snprintf(buf, sizeof(buf), ",\"%s\":\"%s\"",
+               StateJournal::FieldToString(f),
+               ClimateFanModeToString(static_cast<climate::ClimateFanMode>(v)));
+      break;
+    default:
+      snprintf(buf, sizeof(buf), ",\"%s\":%.1f",
+               StateJournal::FieldToString(f), v);
+      break;
+    }
+    json += buf;
+  }
+
+  json += "}";
+  return json;
+}
+
+void OutEquipAC::AppendReportLine(std::string &rpt, const char *host) {
+  char buf[32];
+  auto add_field = [&rpt](const char *name) {
+    if (rpt.back() != ' ')
+      rpt += ",";
+    rpt += name;
+    rpt += "=";
+  };
+  auto add_str = [&](const char *name, const char *val) {
+    add_field(name);
+    rpt += "\"";
+    rpt += val;
+    rpt += "\"";
+  };
+  auto add_int = [&](const char *name, uint32_t val) {
+    add_field(name);
+    snprintf(buf, sizeof(buf), "%" PRIu32 "i", val);
+    rpt += buf;
+  };
+  [[maybe_unused]] auto add_rounded = [&](const char *name, float val) {
+    if (!std::isnan(val))
+      add_int(name, static_cast<uint32_t>(std::round(val)));
+  };
+  [[maybe_unused]] auto add_val = [&](const char *name, float val) {
+    if (std::isnan(val))
+      return;
+    add_field(name);
+    snprintf(buf, sizeof(buf), "%.1f", val);
+    rpt += buf;
+  };
+  [[maybe_unused]] auto sw_str = [](switch_::Switch *sw) -> const char * {
+    if (sw == nullptr || !sw->has_state())
+      return "query";
+    return sw->state ? "on" : "off";
+  };
+  [[maybe_unused]] auto state_of = [](sensor::Sensor *sensor) {
+    return sensor != nullptr ? sensor->state : NAN;
+  };
+
+  if (!rpt.empty() && rpt.back() != '\n')
+    rpt += "\n";
+  rpt += "outequip-ac,host=";
+  rpt += host;
+  if (unit_name_ != nullptr) {
+    rpt += ",unit=";
+    rpt += unit_name_;
+  }
+  rpt += " ";
+
+  add_str("power", ACFramer::OnOffValueToString(cur_power_state_));
+  add_str("mode", ACFramer::ModeValueToString(cur_mode_));
+  add_rounded("set_temp", (this->target_temperature * 9.0f / 5.0f) + 32.0f);
+  add_int("fan_speed", cur_fan_speed_);
+#ifdef USE_OUTEQUIP_AC_UNDERVOLT_SENSOR
+  add_val("undervolt", state_of(undervolt_sensor_));
+#endif
+#ifdef USE_OUTEQUIP_AC_OVERVOLT_SENSOR
+  add_rounded("overvolt", state_of(overvolt_sensor_));
+#endif
+#ifdef USE_OUTEQUIP_AC_INTAKE_TEMP_SENSOR
+  add_rounded("intake_temp", state_of(intake_temp_sensor_));
+#endif
+#ifdef USE_OUTEQUIP_AC_OUTLET_TEMP_SENSOR
+  add_rounded("outlet_temp", state_of(outlet_temp_sensor_));
+#endif
+#ifdef USE_OUTEQUIP_AC_LCD_SWITCH
+  add_str("lcd", sw_str(lcd_switch_));
+#endif
+#ifdef USE_OUTEQUIP_AC_LIGHT_SWITCH
+  add_str("light", sw_str(light_switch_));
+#endif
+#ifdef USE_OUTEQUIP_AC_VOLTAGE_SENSOR
+  add_val("voltage", state_of(voltage_sensor_));
+#endif
+  add_int("uptime_ms", millis());
+  add_int("frames_tx", num_frames_tx_);
+  add_int("frames_rx", num_frames_rx_);
+  add_int("frames_failed", num_frames_failed_);
+  add_int("spurious_bytes_rx", num_spurious_bytes_rx_);
+}
+
+void OutEquipAC::control_after(uint32_t delay_ms, climate::ClimateCall call) {
+  if (delay_ms == 0) {
+    cancel_timeout("control_after");
+    call.perform();
+    return;
+  }
+  set_timeout("control_after", delay_ms, [call]() mutable { call.perform(); });
+}
+
 void OutEquipAC::WriteFrame(ACFramer &framer) {
   expecting_key = framer.GetKey();
-  this->write_array(framer.buffer(), framer.buffer_pos());
+  events_.Record<EventLog::Id::FrameTx>(millis(), framer.GetKey(),
+                                        framer.GetValue());
+  if (arbiter_ != nullptr) {
+    arbiter_->SendLocal(framer, millis());
+  } else {
+    this->write_array(framer.buffer(), framer.buffer_pos());
+  }
   last_frame_sent = millis();
   num_frames_tx_++;
 }
 
 void OutEquipAC::MaybeSendCurFrame() {
+  if (arbiter_ != nullptr && !arbiter_->CanSendLocal(millis())) {
+    return;
+  }
   if (!txQueue.empty()) {
+    // Commands wait for this unit's window too, so a command sent to every
+    // unit at once doesn't hit all the boards together.
+    if (!OutEquipACHub::get()->InWindow(hub_index_, millis())) {
+      return;
+    }
     WriteFrame(txQueue.front());
+    scenes_.OnWritten(txQueue.front().GetKey(), txQueue.front().GetValue());
     txQueue.pop();
     return;
   }
   if (millis() - last_full_status < 1000) {
     return;
   }
+  // Take our turn among the units sharing this ESP32 before starting a cycle.
+  if (!cycle_started_) {
+    if (!OutEquipACHub::get()->TryStartCycle(hub_index_, millis())) {
+      return;
+    }
+    cycle_started_ = true;
+  }
+  // Skip keys the app has just refreshed for us.
+  while (arbiter_ != nullptr &&
+         millis() - snooped_at_[cur_query_key_idx] < kSnoopFreshMs) {
+    if (AdvanceQueryKey()) {
+      return;
+    }
+  }
+  ACFramer txFramer;
+  txFramer.NewFrame(kQueryKeys[cur_query_key_idx], ACFramer::kQueryVal);
+  WriteFrame(txFramer);
+}
+
+#ifdef USE_OUTEQUIP_AC_BENCHMARK
+void OutEquipAC::StartBenchmark() {
+  if (benchmark_.running()) {
+    return;
+  }
+  if (arbiter_ != nullptr) {
+    // The app's traffic would skew the numbers, and flooding the board would
+    // starve the app.
+    ESP_LOGW("outequip_ac", "Link benchmark unavailable in passthrough mode");
+    return;
+  }
+  ESP_LOGI("outequip_ac", "Link benchmark running for %" PRIu32 " ms",
+           benchmark_duration_);
+  expecting_key.reset();
+  benchmark_.Start(millis(), benchmark_duration_, BenchmarkCounters());
+  // The default loop interval would cap the frame rate, not the link.
+  high_freq_.start();
+}
+
+void OutEquipAC::StepBenchmark() {
+  const uint32_t now = millis();
+  if (!benchmark_.ShouldSend(now)) {
+    return;
+  }
+  if (benchmark_.Expired(now)) {
+    FinishBenchmark();
+    return;
+  }
+  // A timed-out frame's reply is no longer awaited.
+  expecting_key.reset();
+  // Only queries: set replies carry the last queried key, so a command would
+  // count as a timeout. Walking the poll table keeps state fresh meanwhile.
   ACFramer txFramer;
   txFramer.NewFrame(kQueryKeys[cur_query_key_idx], ACFramer::kQueryVal);
   WriteFrame(txFramer);
+  benchmark_.OnSent(now);
+}
+
+LinkBenchmark::Result OutEquipAC::StopBenchmark() {
+  high_freq_.stop();
+  expecting_key.reset();
+  // Held-back scene frames go out now; give them the full timeout.
+  if (scenes_.HasPending()) {
+    scene_sent_at_ = millis();
+  }
+  return benchmark_.Finish(millis(), BenchmarkCounters());
+}
+
+void OutEquipAC::FinishBenchmark() {
+  const auto result = StopBenchmark();
+  ESP_LOGI("outequip_ac",
+           "Link benchmark: %.1f frames/s, RTT median %.0f ms, p95 %.0f ms, "
+           "max %.0f ms (%" PRIu32 " over 127 ms), %.1f%% failed, %" PRIu32
+           " spurious bytes, %" PRIu32 " timeouts",
+           result.frame_rate, result.rtt_median_ms, result.rtt_p95_ms,
+           result.rtt_max_ms, result.slow_replies, result.failure_rate,
+           result.spurious_bytes, result.timeouts);
+
+  auto publish = [](sensor::Sensor *sensor, float value) {
+    if (sensor != nullptr) {
+      sensor->publish_state(value);
+    }
+  };
+  publish(benchmark_frame_rate_sensor_, result.frame_rate);
+  publish(benchmark_rtt_median_sensor_, result.rtt_median_ms);
+  publish(benchmark_rtt_p95_sensor_, result.rtt_p95_ms);
+  publish(benchmark_rtt_max_sensor_, result.rtt_max_ms);
+  publish(benchmark_failure_rate_sensor_, result.failure_rate);
+  publish(benchmark_spurious_bytes_sensor_, result.spurious_bytes);
+  publish(benchmark_timeouts_sensor_, result.timeouts);
+  publish(benchmark_slow_replies_sensor_, result.slow_replies);
+}
+#endif
+
+bool OutEquipAC::AdvanceQueryKey() {
+  if (++cur_query_key_idx >= kNumQueryKeys) {
+    cur_query_key_idx = 0;
+    cycle_started_ = false;
+    last_full_status = millis();
+    return true;
+  }
+  return false;
 }
 
 bool OutEquipAC::EnqueueFrame(ACFramer::Key key, uint16_t value) {
   ACFramer txFramer;
   if (!txFramer.NewFrame(key, value))
     return false;
+  events_.Record<EventLog::Id::Command>(millis(), key, value);
   txQueue.push(txFramer);
   return true;
 }
 
+size_t OutEquipAC::QueryKeyIndex(ACFramer::Key key) {
+  for (size_t i = 0; i < kNumQueryKeys; ++i) {
+    if (kQueryKeys[i] == key) {
+      return i;
+    }
+  }
+  return kNumQueryKeys;
+}
+
+void OutEquipAC::DrainEventsToLog() {
+  if (logged_seq_ < events_.first_seq()) {
+    logged_seq_ = events_.first_seq();
+  }
+  char msg[64];
+  EventLog::Event event;
+  // Spread a burst over several loops rather than stalling this one.
+  for (size_t i = 0; i < kMaxEventsLoggedPerLoop &&
+                     events_.Get(logged_seq_, &event);
+       ++i, ++logged_seq_) {
+    EventLog::Format(event, msg, sizeof(msg));
+    switch (EventLog::LevelOf(event.id)) {
+    case EventLog::Level::Verbose:
+      ESP_LOGV("outequip_ac", "%s", msg);
+      break;
+    case EventLog::Level::Debug:
+      ESP_LOGD("outequip_ac", "%s", msg);
+      break;
+    case EventLog::Level::Info:
+      ESP_LOGI("outequip_ac", "%s", msg);
+      break;
+    case EventLog::Level::Warn:
+      ESP_LOGW("outequip_ac", "%s", msg);
+      break;
+    }
+  }
+}
+
 constexpr ACFramer::Key OutEquipAC::kQueryKeys[];
 
+OutEquipACHub *OutEquipACHub::get() {
+  static OutEquipACHub hub;
+  return &hub;
+}
+
+size_t OutEquipACHub::AddUnit(OutEquipAC *unit) {
+  units_.push_back(unit);
+  return scheduler_.AddUnit();
+}
+
+OutEquipAC *OutEquipACHub::FindUnit(const char *unit_name) const {
+  if (units_.empty()) {
+    return nullptr;
+  }
+  if (unit_name == nullptr || *unit_name == '\0') {
+    return units_.front();
+  }
+  for (auto *unit : units_) {
+    if (unit->unit_name() != nullptr &&
+        strcmp(unit->unit_name(), unit_name) == 0) {
+      return unit;
+    }
+  }
+  return nullptr;
+}
+
+#ifdef USE_OUTEQUIP_AC_TELEMETRY
+void OutEquipACHub::SetupTelemetry(size_t buffer_size, size_t flash_blocks,
+                                   size_t max_packet_size,
+                                   time::RealTimeClock *clock,
+                                   bool confirm_delivery) {
+  telemetry_.set_capacity(buffer_size);
+  max_packet_size_ = max_packet_size;
+  clock_ = clock;
+  confirm_delivery_ = confirm_delivery;
+  if (flash_blocks == 0) {
+    return;
+  }
+
+  // Preferences already batch flash commits; the ring adds to that by only
+  // saving whole blocks, and the sent seq once per drained backlog.
+  const uint32_t hash = fnv1_hash("outequip_ac_telemetry");
+  sent_seq_pref_ = global_preferences->make_preference<uint32_t>(hash, true);
+  for (size_t i = 0; i < flash_blocks; ++i) {
+    telemetry_prefs_.push_back(
+        global_preferences->make_preference<TelemetryRing::Block>(
+            hash + 1 + i, true));
+  }
+  uint32_t sent_seq = 0;
+  sent_seq_pref_.load(&sent_seq);
+  telemetry_.EnableFlash(
+      flash_blocks,
+      [this](size_t slot, TelemetryRing::Block *block) {
+        return telemetry_prefs_[slot].load(block);
+      },
+      [this](size_t slot, const TelemetryRing::Block &block) {
+        return telemetry_prefs_[slot].save(&block);
+      },
+      [this](uint32_t seq) { return sent_seq_pref_.save(&seq); }, sent_seq);
+}
+
+uint32_t OutEquipACHub::Epoch() {
+  if (clock_ != nullptr) {
+    const auto now = clock_->now();
+    if (now.is_valid()) {
+      return now.timestamp;
+    }
+  }
+  return 0;
+}
+
+void OutEquipACHub::QueueReport(const char *host) {
+  const uint32_t now = millis();
+  const uint32_t epoch = Epoch();
+  std::string line;
+  for (auto *unit : units_) {
+    line.clear();
+    unit->AppendReportLine(line, host);
+    telemetry_.Push(line, now, epoch);
+  }
+
+  char buf[224];
+  snprintf(buf, sizeof(buf),
+           "outequip-ac-telemetry,host=%s queued=%zui,fill_bytes=%zui,"
+           "capacity_bytes=%zui,dropped=%" PRIu32 "i,spilled=%" PRIu32
+           "i,flash_write_failures=%" PRIu32 "i,undelivered=%" PRIu32 "i",
+           host, telemetry_.size(), telemetry_.fill_bytes(),
+           telemetry_.capacity(), telemetry_.num_dropped(),
+           telemetry_.num_spilled(), telemetry_.num_flash_write_failures(),
+           num_undelivered_);
+  telemetry_.Push(buf, now, epoch);
+}
+
+bool OutEquipACHub::TelemetryReady() {
+  if (awaiting_delivery_) {
+    if (millis() - packet_sent_at_ < kDeliveryTimeoutMs) {
+      return false;
+    }
+    TelemetryDelivered(false);
+  }
+  if (undelivered_at_.has_value()) {
+    if (millis() - *undelivered_at_ < kRetryMs) {
+      return false;
+    }
+    undelivered_at_.reset();
+  }
+  if (telemetry_.empty()) {
+    return false;
+  }
+  // If the clock never gets set, unstamped lines beat none at all.
+  return clock_ == nullptr || Epoch() != 0 || millis() >= kClockWaitMs;
+}
+
+std::string OutEquipACHub::NextTelemetryPacket() {
+  if (confirm_delivery_) {
+    awaiting_delivery_ = true;
+    packet_sent_at_ = millis();
+  }
+  return telemetry_.NextPacket(max_packet_size_, millis(), Epoch());
+}
+
+void OutEquipACHub::TelemetryDelivered(bool delivered) {
+  if (!awaiting_delivery_) {
+    return;
+  }
+  awaiting_delivery_ = false;
+  if (delivered) {
+    telemetry_.Commit();
+    return;
+  }
+  // Keep the backlog until InfluxDB is back, rather than draining it into
+  // the void.
+  telemetry_.Requeue();
+  num_undelivered_++;
+  undelivered_at_ = millis();
+}
+#endif
+
+#ifdef USE_WEBSERVER
+bool OutEquipACStateHandler::canHandle(AsyncWebServerRequest *request) const {
+  return request->method() == HTTP_GET &&
+         request->url() == "/outequip_ac/state";
+}
+
+void OutEquipACStateHandler::handleRequest(AsyncWebServerRequest *request) {
+  uint32_t epoch = 0;
+  uint32_t since = 0;
+  if (request->hasArg("epoch")) {
+    epoch = parse_number<uint32_t>(request->arg("epoch")).value_or(0);
+  }
+  if (request->hasArg("since")) {
+    since = parse_number<uint32_t>(request->arg("since")).value_or(0);
+  }
+  std::string unit_name;
+  if (request->hasArg("unit")) {
+    unit_name = request->arg("unit").c_str();
+  }
+  auto *unit = OutEquipACHub::get()->FindUnit(unit_name.c_str());
+  if (unit == nullptr) {
+    request->send(404);
+    return;
+  }
+  auto *response = request->beginResponse(200, "application/json",
+                                          unit->BuildStateJson(epoch, since));
+  response->addHeader("Cache-Control", "no-store");
+  request->send(response);
+}
+
+bool OutEquipACLogHandler::canHandle(AsyncWebServerRequest *request) const {
+  return request->method() == HTTP_GET && request->url() == "/outequip_ac/log";
+}
+
+void OutEquipACLogHandler::handleRequest(AsyncWebServerRequest *request) {
+  std::string unit_name;
+  if (request->hasArg("unit")) {
+    unit_name = request->arg("unit").c_str();
+  }
+  auto *unit = OutEquipACHub::get()->FindUnit(unit_name.c_str());
+  if (unit == nullptr) {
+    request->send(404);
+    return;
+  }
+  const EventLog &events = unit->events();
+  uint32_t seq = events.first_seq();
+  if (request->hasArg("since")) {
+    seq = events.ClampSeq(
+        parse_number<uint32_t>(request->arg("since")).value_or(0));
+  }
+
+  // Formatted here, on request, rather than when the events were recorded.
+  // One line per event: <seq> <millis> <level> <message>
+  std::string text;
+  text.reserve(64 * (events.next_seq() - seq));
+  char line[96];
+  EventLog::Event event;
+  for (; events.Get(seq, &event); ++seq) {
+    int n = snprintf(line, sizeof(line), "%" PRIu32 " %" PRIu32 " %s ", seq,
+                     event.at,
+                     EventLog::LevelToString(EventLog::LevelOf(event.id)));
+    if (n < 0 || n >= static_cast<int>(sizeof(line))) {
+      continue;
+    }
+    EventLog::Format(event, line + n, sizeof(line) - n);
+    text += line;
+    text += "\n";
+  }
+  auto *response = request->beginResponse(200, "text/plain", text);
+  response->addHeader("Cache-Control", "no-store");
+  request->send(response);
+}
+#endif
+
 } // namespace outequip_ac
 } // namespace esphome
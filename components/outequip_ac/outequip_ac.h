@@ -1,13 +1,38 @@
 #pragma once
 
 #include "ac_framer.h"
+#include "event_log.h"
+#include "hub_scheduler.h"
+#include "link_benchmark.h"
+#include "passthrough_arbiter.h"
+#include "rule_engine.h"
+#include "scene_planner.h"
+#include "state_journal.h"
+#include "telemetry_ring.h"
 #include "esphome/components/climate/climate.h"
 #include "esphome/components/sensor/sensor.h"
 #include "esphome/components/switch/switch.h"
 #include "esphome/components/uart/uart.h"
 #include "esphome/core/component.h"
+#include "esphome/core/defines.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/preferences.h"
+#include <functional>
 #include <optional>
 #include <queue>
+#include <string>
+#include <vector>
+
+#ifdef USE_WEBSERVER
+#include "esphome/components/web_server_base/web_server_base.h"
+#include "web_assets.h"
+#endif
+#if defined(USE_OUTEQUIP_AC_TIME) || defined(USE_OUTEQUIP_AC_TELEMETRY)
+#include "esphome/components/time/real_time_clock.h"
+#endif
+#ifdef USE_OUTEQUIP_AC_BENCHMARK
+#include "esphome/components/button/button.h"
+#endif
 
 namespace esphome {
 namespace outequip_ac {
@@ -28,35 +53,150 @@ protected:
   OutEquipACSwitchType type_;
 };
 
+#ifdef USE_OUTEQUIP_AC_BENCHMARK
+class OutEquipACBenchmarkButton : public button::Button {
+public:
+  void set_parent(OutEquipAC *parent) { parent_ = parent; }
+
+protected:
+  void press_action() override;
+
+  OutEquipAC *parent_{nullptr};
+};
+#endif
+
 class OutEquipAC : public Component,
                    public climate::Climate,
                    public uart::UARTDevice {
 public:
   OutEquipAC() = default;
 
+#ifdef USE_OUTEQUIP_AC_INTAKE_TEMP_SENSOR
   void set_intake_temp_sensor(sensor::Sensor *sensor) {
     intake_temp_sensor_ = sensor;
   }
+#endif
+#ifdef USE_OUTEQUIP_AC_OUTLET_TEMP_SENSOR
   void set_outlet_temp_sensor(sensor::Sensor *sensor) {
     outlet_temp_sensor_ = sensor;
   }
+#endif
+#ifdef USE_OUTEQUIP_AC_VOLTAGE_SENSOR
   void set_voltage_sensor(sensor::Sensor *sensor) { voltage_sensor_ = sensor; }
+#endif
+#ifdef USE_OUTEQUIP_AC_UNDERVOLT_SENSOR
   void set_undervolt_sensor(sensor::Sensor *sensor) {
     undervolt_sensor_ = sensor;
   }
+#endif
+#ifdef USE_OUTEQUIP_AC_OVERVOLT_SENSOR
   void set_overvolt_sensor(sensor::Sensor *sensor) {
     overvolt_sensor_ = sensor;
   }
+#endif
+#ifdef USE_OUTEQUIP_AC_AMPERAGE_SENSOR
   void set_amperage_sensor(sensor::Sensor *sensor) {
     amperage_sensor_ = sensor;
   }
+#endif
+#ifdef USE_OUTEQUIP_AC_BENCHMARK
+  void set_benchmark_frame_rate_sensor(sensor::Sensor *sensor) {
+    benchmark_frame_rate_sensor_ = sensor;
+  }
+  void set_benchmark_rtt_median_sensor(sensor::Sensor *sensor) {
+    benchmark_rtt_median_sensor_ = sensor;
+  }
+  void set_benchmark_rtt_p95_sensor(sensor::Sensor *sensor) {
+    benchmark_rtt_p95_sensor_ = sensor;
+  }
+  void set_benchmark_rtt_max_sensor(sensor::Sensor *sensor) {
+    benchmark_rtt_max_sensor_ = sensor;
+  }
+  void set_benchmark_failure_rate_sensor(sensor::Sensor *sensor) {
+    benchmark_failure_rate_sensor_ = sensor;
+  }
+  void set_benchmark_spurious_bytes_sensor(sensor::Sensor *sensor) {
+    benchmark_spurious_bytes_sensor_ = sensor;
+  }
+  void set_benchmark_timeouts_sensor(sensor::Sensor *sensor) {
+    benchmark_timeouts_sensor_ = sensor;
+  }
+  void set_benchmark_slow_replies_sensor(sensor::Sensor *sensor) {
+    benchmark_slow_replies_sensor_ = sensor;
+  }
+  void set_benchmark_duration(uint32_t duration_ms) {
+    benchmark_duration_ = duration_ms;
+  }
+
+  /**
+   * @brief Query the board back to back for the benchmark duration, then
+   * publish the link's frame rate, RTTs and error counts. Normal polling
+   * and queued commands wait until it finishes; a local rule firing aborts
+   * it.
+   */
+  void StartBenchmark();
+#endif
+#ifdef USE_OUTEQUIP_AC_LCD_SWITCH
   void set_lcd_switch(switch_::Switch *lcd_switch) { lcd_switch_ = lcd_switch; }
+#endif
+#ifdef USE_OUTEQUIP_AC_SWING_SWITCH
   void set_swing_switch(switch_::Switch *swing_switch) {
     swing_switch_ = swing_switch;
   }
+#endif
+#ifdef USE_OUTEQUIP_AC_LIGHT_SWITCH
   void set_light_switch(switch_::Switch *light_switch) {
     light_switch_ = light_switch;
   }
+#endif
+  // Sit inline between the board and the original Bluetooth module on this
+  // UART, forwarding the app's traffic and interleaving our own.
+  void set_passthrough_uart(uart::UARTComponent *passthrough_uart) {
+    passthrough_uart_ = passthrough_uart;
+  }
+#ifdef USE_WEBSERVER
+  void set_asset_handler(OutEquipACAssetHandler *asset_handler) {
+    asset_handler_ = asset_handler;
+  }
+#endif
+  // Tags this unit's stats and selects it on the state endpoint when several
+  // units share one ESP32.
+  void set_unit_name(const char *unit_name) { unit_name_ = unit_name; }
+  const char *unit_name() const { return unit_name_; }
+  // Also format recorded events to the logger, a few per loop.
+  void set_log_events(bool log_events) { log_events_ = log_events; }
+#ifdef USE_OUTEQUIP_AC_TIME
+  void set_time(time::RealTimeClock *time) { time_ = time; }
+#endif
+#ifdef USE_OUTEQUIP_AC_TELEMETRY
+  // Queue the hub's stats reports; see OutEquipACHub::QueueReport().
+  void set_telemetry(size_t buffer_size, size_t flash_blocks,
+                     size_t max_packet_size, bool confirm_delivery) {
+    telemetry_buffer_size_ = buffer_size;
+    telemetry_flash_blocks_ = flash_blocks;
+    telemetry_max_packet_size_ = max_packet_size;
+    telemetry_confirm_delivery_ = confirm_delivery;
+  }
+#endif
+
+  // Local rules, built up from YAML. The set_rule_* calls apply to the most
+  // recently added rule, to its clear action if on_clear is set.
+  void add_threshold_rule(RuleEngine::Input input, float threshold, bool above,
+                          float hysteresis) {
+    last_rule_ = rules_.AddThreshold(input, threshold, above, hysteresis);
+  }
+  void add_schedule_rule(uint16_t minute_of_day) {
+    last_rule_ = rules_.AddSchedule(minute_of_day);
+  }
+  void set_rule_mode(bool on_clear, climate::ClimateMode mode) {
+    RuleAction(on_clear).mode = mode;
+  }
+  void set_rule_target_temperature(bool on_clear, float target_temperature) {
+    RuleAction(on_clear).target_temperature = target_temperature;
+  }
+  void set_rule_fan_mode(bool on_clear, climate::ClimateFanMode fan_mode) {
+    RuleAction(on_clear).fan_mode = fan_mode;
+  }
 
   void set_lcd_state(bool state);
   void set_swing_state(bool state);
@@ -74,46 +214,209 @@ public:
   uint32_t num_frames_rx() const { return num_frames_rx_; }
   uint32_t num_frames_failed() const { return num_frames_failed_; }
   uint32_t num_spurious_bytes_rx() const { return num_spurious_bytes_rx_; }
+  uint32_t num_app_frames() const {
+    return arbiter_ != nullptr ? arbiter_->num_app_frames() : 0;
+  }
+  const EventLog &events() const { return events_; }
+
+  /**
+   * @brief Render the state journal as JSON for a client last synced at
+   * (epoch, since). Only fields changed since then are included, unless the
+   * client is too far behind, in which case a full snapshot is returned.
+   */
+  std::string BuildStateJson(uint32_t epoch, uint32_t since);
+
+  /**
+   * @brief Append this unit's stats to rpt as one InfluxDB line protocol line.
+   */
+  void AppendReportLine(std::string &rpt, const char *host);
+
+  // Perform call after delay_ms. A later call replaces one still pending.
+  void control_after(uint32_t delay_ms, climate::ClimateCall call);
+
+  // Add climate settings to a scene as the board values that produce them.
+  static void AddClimateMode(ScenePlanner::Scene &scene,
+                             climate::ClimateMode mode);
+  static void AddTargetTemperature(ScenePlanner::Scene &scene,
+                                   float target_temperature);
+  static void AddFanMode(ScenePlanner::Scene &scene,
+                         climate::ClimateFanMode fan_mode);
+  static void AddLcd(ScenePlanner::Scene &scene, bool on);
+  static void AddLight(ScenePlanner::Scene &scene, bool on);
+
+  /**
+   * @brief Send only the frames needed to move the board from its confirmed
+   * state to scene. With report set, the scene complete callbacks run once
+   * the board has confirmed every frame, or the frames time out. A target
+   * temperature outside the visual range is dropped with a warning.
+   */
+  void ApplyScene(const ScenePlanner::Scene &scene, bool report);
+  void add_on_scene_complete_callback(std::function<void(bool)> &&callback) {
+    scene_complete_callback_.add(std::move(callback));
+  }
 
 protected:
+#ifdef USE_OUTEQUIP_AC_INTAKE_TEMP_SENSOR
   sensor::Sensor *intake_temp_sensor_{nullptr};
+#endif
+#ifdef USE_OUTEQUIP_AC_OUTLET_TEMP_SENSOR
   sensor::Sensor *outlet_temp_sensor_{nullptr};
+#endif
+#ifdef USE_OUTEQUIP_AC_VOLTAGE_SENSOR
   sensor::Sensor *voltage_sensor_{nullptr};
+#endif
+#ifdef USE_OUTEQUIP_AC_UNDERVOLT_SENSOR
   sensor::Sensor *undervolt_sensor_{nullptr};
+#endif
+#ifdef USE_OUTEQUIP_AC_OVERVOLT_SENSOR
   sensor::Sensor *overvolt_sensor_{nullptr};
+#endif
+#ifdef USE_OUTEQUIP_AC_AMPERAGE_SENSOR
   sensor::Sensor *amperage_sensor_{nullptr};
+#endif
+#ifdef USE_OUTEQUIP_AC_BENCHMARK
+  sensor::Sensor *benchmark_frame_rate_sensor_{nullptr};
+  sensor::Sensor *benchmark_rtt_median_sensor_{nullptr};
+  sensor::Sensor *benchmark_rtt_p95_sensor_{nullptr};
+  sensor::Sensor *benchmark_rtt_max_sensor_{nullptr};
+  sensor::Sensor *benchmark_failure_rate_sensor_{nullptr};
+  sensor::Sensor *benchmark_spurious_bytes_sensor_{nullptr};
+  sensor::Sensor *benchmark_timeouts_sensor_{nullptr};
+  sensor::Sensor *benchmark_slow_replies_sensor_{nullptr};
+  uint32_t benchmark_duration_{10000};
+#endif
+#ifdef USE_OUTEQUIP_AC_LCD_SWITCH
   switch_::Switch *lcd_switch_{nullptr};
+#endif
+#ifdef USE_OUTEQUIP_AC_SWING_SWITCH
   switch_::Switch *swing_switch_{nullptr};
+#endif
+#ifdef USE_OUTEQUIP_AC_LIGHT_SWITCH
   switch_::Switch *light_switch_{nullptr};
+#endif
+  uart::UARTComponent *passthrough_uart_{nullptr};
+#ifdef USE_WEBSERVER
+  OutEquipACAssetHandler *asset_handler_{nullptr};
+#endif
+#ifdef USE_OUTEQUIP_AC_TIME
+  time::RealTimeClock *time_{nullptr};
+#endif
+#ifdef USE_OUTEQUIP_AC_TELEMETRY
+  size_t telemetry_buffer_size_{0};
+  size_t telemetry_flash_blocks_{0};
+  size_t telemetry_max_packet_size_{0};
+  bool telemetry_confirm_delivery_{false};
+#endif
+  const char *unit_name_{nullptr};
 
 private:
+  void HandleFrame(const ACFramer &frame, bool local);
+  // A board byte that broke a frame_len byte frame, or a stray byte if 0.
+  void HandleRxError(uint8_t c, size_t frame_len);
   void WriteFrame(ACFramer &framer);
   void MaybeSendCurFrame();
+  // Returns true when a full poll cycle has completed.
+  bool AdvanceQueryKey();
   bool EnqueueFrame(ACFramer::Key key, uint16_t value);
+  void UpdateClimateJournal();
+  void ApplyRuleAction(size_t rule, bool cleared,
+                       const RuleEngine::Action &action);
+  RuleEngine::Action &RuleAction(bool on_clear) {
+    return on_clear ? rules_.on_clear(last_rule_) : rules_.then(last_rule_);
+  }
+  void DrainEventsToLog();
+  void CompleteScene(bool success);
+  bool Benchmarking() const {
+#ifdef USE_OUTEQUIP_AC_BENCHMARK
+    return benchmark_.running();
+#else
+    return false;
+#endif
+  }
+#ifdef USE_OUTEQUIP_AC_BENCHMARK
+  // Sends the next benchmark frame once the last one is answered, and ends
+  // the run when its time is up.
+  void StepBenchmark();
+  // Ends the run and publishes its results.
+  void FinishBenchmark();
+  // Ends the run, releasing held-back commands, without publishing.
+  LinkBenchmark::Result StopBenchmark();
+  LinkBenchmark::Counters BenchmarkCounters() const {
+    return {num_frames_rx_, num_frames_failed_, num_spurious_bytes_rx_};
+  }
+#endif
+  // Returns kNumQueryKeys for keys that aren't polled.
+  static size_t QueryKeyIndex(ACFramer::Key key);
 
+  // Keys polled in rotation. Climate keys are always polled; the rest are only
+  // compiled in when their entity is configured (see sensor.py / switch.py), so
+  // unused keys never go on the wire.
   constexpr static ACFramer::Key kQueryKeys[] = {
       ACFramer::Key::Power,
       ACFramer::Key::Mode,
       ACFramer::Key::SetTemperature,
       ACFramer::Key::FanSpeed,
+#ifdef USE_OUTEQUIP_AC_UNDERVOLT_SENSOR
       ACFramer::Key::UndervoltProtect,
+#endif
+#ifdef USE_OUTEQUIP_AC_OVERVOLT_SENSOR
       ACFramer::Key::OvervoltProtect,
+#endif
       ACFramer::Key::IntakeAirTemp,
+#ifdef USE_OUTEQUIP_AC_OUTLET_TEMP_SENSOR
       ACFramer::Key::OutletAirTemp,
+#endif
       // Summit2 firmware has light/lcd status reporting is buggy. Ignore.
+#ifdef USE_OUTEQUIP_AC_LCD_SWITCH
       ACFramer::Key::LCD,
+#endif
       // ACFramer::Key::Light,
+#ifdef USE_OUTEQUIP_AC_SWING_SWITCH
       ACFramer::Key::Swing,
+#endif
+#if defined(USE_OUTEQUIP_AC_VOLTAGE_SENSOR) ||                               \
+    defined(USE_OUTEQUIP_AC_VOLTAGE_RULES)
       ACFramer::Key::Voltage,
+#endif
+#ifdef USE_OUTEQUIP_AC_AMPERAGE_SENSOR
       ACFramer::Key::Amperage,
+#endif
   };
+  constexpr static size_t kNumQueryKeys =
+      sizeof(kQueryKeys) / sizeof(*kQueryKeys);
+
+  // Snooped replies younger than this stand in for our own poll of that key.
+  static const uint32_t kSnoopFreshMs = 1000;
+  static const size_t kMaxEventsLoggedPerLoop = 4;
+  // Frames the board hasn't confirmed by then are presumed lost.
+  static const uint32_t kSceneTimeoutMs = 5000;
 
   size_t cur_query_key_idx = 0;
+  size_t hub_index_ = 0;
+  bool cycle_started_ = false;
+  uint32_t snooped_at_[kNumQueryKeys] = {};
+  std::optional<uint16_t> last_values_[kNumQueryKeys];
+  PassthroughArbiter *arbiter_{nullptr};
   uint32_t last_frame_sent = 0;
   uint32_t last_full_status = 0;
   std::queue<ACFramer> txQueue;
   std::optional<ACFramer::Key> expecting_key;
   ACFramer rxFramer;
+  StateJournal journal_;
+  EventLog events_;
+  RuleEngine rules_;
+  ScenePlanner scenes_;
+  uint32_t scene_sent_at_{0};
+  bool scene_reporting_{false};
+  CallbackManager<void(bool)> scene_complete_callback_;
+  size_t last_rule_{0};
+  uint32_t last_clock_check_{0};
+  bool log_events_{false};
+  uint32_t logged_seq_{0};
+#ifdef USE_OUTEQUIP_AC_BENCHMARK
+  LinkBenchmark benchmark_;
+  HighFrequencyLoopRequester high_freq_;
+#endif
 
   ACFramer::OnOffValue cur_power_state_ = ACFramer::OnOffValue::Query;
   ACFramer::ModeValue cur_mode_ = ACFramer::ModeValue::Query;
@@ -124,5 +427,99 @@ private:
   uint32_t num_spurious_bytes_rx_{0};
 };
 
+// All units on this ESP32. Their poll cycles are staggered so the loop isn't
+// busy with every UART at once, and their stats go out in one report.
+class OutEquipACHub {
+public:
+  static OutEquipACHub *get();
+
+  // Returns the unit's index in the hub's scheduler.
+  size_t AddUnit(OutEquipAC *unit);
+  bool TryStartCycle(size_t index, uint32_t now) {
+    return scheduler_.TryStartCycle(index, now);
+  }
+  bool InWindow(size_t index, uint32_t now) const {
+    return scheduler_.InWindow(index, now);
+  }
+  // Looks a unit up by unit_name; nullptr or empty selects the first unit.
+  OutEquipAC *FindUnit(const char *unit_name) const;
+  const std::vector<OutEquipAC *> &units() const { return units_; }
+
+#ifdef USE_OUTEQUIP_AC_TELEMETRY
+  /**
+   * @brief Hold reports in a ring of up to buffer_size bytes, spilling to
+   * flash_blocks preference blocks once full, and send them in packets of
+   * up to max_packet_size. Lines are stamped from clock, if set. With
+   * confirm_delivery, each packet waits for TelemetryDelivered().
+   */
+  void SetupTelemetry(size_t buffer_size, size_t flash_blocks,
+                      size_t max_packet_size, time::RealTimeClock *clock,
+                      bool confirm_delivery);
+  // Queue each unit's stats line, plus one for the queue itself, stamped
+  // with the time taken.
+  void QueueReport(const char *host);
+  /**
+   * @brief Whether there's a packet to send. With a clock, lines wait up to
+   * kClockWaitMs after boot for it to be set so they can be stamped, then go
+   * out unstamped. With confirm_delivery, nothing is ready while a packet
+   * awaits confirmation, nor for kRetryMs after one wasn't delivered.
+   */
+  bool TelemetryReady();
+  // The oldest queued lines, as one multi-line packet.
+  std::string NextTelemetryPacket();
+  /**
+   * @brief Report whether the last packet reached InfluxDB, e.g. from a
+   * /ping sent right after it. An undelivered packet is queued again.
+   */
+  void TelemetryDelivered(bool delivered);
+  const TelemetryRing &telemetry() const { return telemetry_; }
+#endif
+
+protected:
+  HubScheduler scheduler_;
+  std::vector<OutEquipAC *> units_;
+#ifdef USE_OUTEQUIP_AC_TELEMETRY
+  // Wall clock seconds, or 0 when unknown.
+  uint32_t Epoch();
+  // Longer than SNTP normally takes, short enough not to fill the buffer.
+  static const uint32_t kClockWaitMs = 60000;
+  // A confirmation that hasn't come by then counts as a failure.
+  static const uint32_t kDeliveryTimeoutMs = 10000;
+  static const uint32_t kRetryMs = 10000;
+
+  TelemetryRing telemetry_;
+  size_t max_packet_size_{1400};
+  bool confirm_delivery_{false};
+  bool awaiting_delivery_{false};
+  uint32_t packet_sent_at_{0};
+  std::optional<uint32_t> undelivered_at_;
+  uint32_t num_undelivered_{0};
+  time::RealTimeClock *clock_{nullptr};
+  std::vector<ESPPreferenceObject> telemetry_prefs_;
+  ESPPreferenceObject sent_seq_pref_;
+#endif
+};
+
+#ifdef USE_WEBSERVER
+// Serves the state journal at /outequip_ac/state so the thermostat page can
+// resync with a small delta instead of reopening /events for a full dump. With
+// several units, ?unit=<unit_name> picks one.
+class OutEquipACStateHandler : public AsyncWebHandler {
+public:
+  bool canHandle(AsyncWebServerRequest *request) const override;
+  void handleRequest(AsyncWebServerRequest *request) override;
+  bool isRequestHandlerTrivial() const override { return false; }
+};
+
+// Dumps a unit's event log as text at /outequip_ac/log. ?since=<seq> returns
+// only newer events, ?unit=<unit_name> picks the unit.
+class OutEquipACLogHandler : public AsyncWebHandler {
+public:
+  bool canHandle(AsyncWebServerRequest *request) const override;
+  void handleRequest(AsyncWebServerRequest *request) override;
+  bool isRequestHandlerTrivial() const override { return false; }
+};
+#endif
+
 } // namespace outequip_ac
 } // namespace esphome
@@ -0,0 +1,118 @@
+#include "passthrough_arbiter.h"
+
+#include <utility>
+
+PassthroughArbiter::PassthroughArbiter(WriteFn write_board,
+                                       WriteFn write_module,
+                                       FrameFn on_board_frame)
+    : write_board_(std::move(write_board)),
+      write_module_(std::move(write_module)),
+      on_board_frame_(std::move(on_board_frame)) {}
+
+void PassthroughArbiter::OnBoardByte(uint8_t c, uint32_t now) {
+  const bool local = owner_ == Owner::Local;
+  if (!local) {
+    write_module_(&c, 1);
+  }
+
+  if (!board_framer_.FrameData(c)) {
+    const size_t frame_len = board_framer_.buffer_pos();
+    board_framer_.Reset();
+    // The board talks AT commands to the module in plain text; only other
+    // bytes outside a frame are noise.
+    const bool text = (c >= 0x20 && c < 0x7f) || c == '\r' || c == '\n';
+    if (frame_len == 0 && text) {
+      return;
+    }
+    if (frame_len > 0) {
+      num_frames_failed_++;
+    } else {
+      num_spurious_bytes_rx_++;
+    }
+    if (on_board_error_) {
+      on_board_error_(c, frame_len);
+    }
+    return;
+  }
+  if (!board_framer_.HasFullFrame()) {
+    return;
+  }
+
+  // The board answers every request with exactly one frame, so any full frame
+  // ends the current exchange. Let the app's held request go first, before
+  // the frame handler gets a chance to queue our next one.
+  owner_ = Owner::None;
+  if (local) {
+    ReleaseHeldBytes(now);
+  }
+  on_board_frame_(board_framer_, local);
+  board_framer_.Reset();
+}
+
+void PassthroughArbiter::OnModuleByte(uint8_t c, uint32_t now) {
+  last_module_byte_at_ = now;
+  if (owner_ == Owner::Local) {
+    if (held_len_ < sizeof(held_)) {
+      held_[held_len_++] = c;
+    } else {
+      num_held_bytes_dropped_++;
+    }
+    return;
+  }
+  ForwardToBoard(c, now);
+}
+
+void PassthroughArbiter::Poll(uint32_t now) {
+  if (owner_ == Owner::None || now - request_sent_at_ < kResponseTimeoutMs) {
+    return;
+  }
+  const bool local = owner_ == Owner::Local;
+  owner_ = Owner::None;
+  board_framer_.Reset();
+  if (local) {
+    ReleaseHeldBytes(now);
+  }
+}
+
+bool PassthroughArbiter::CanSendLocal(uint32_t now) const {
+  return owner_ == Owner::None && held_len_ == 0 &&
+         module_framer_.buffer_pos() == 0 &&
+         now - last_module_byte_at_ >= kIdleGapMs;
+}
+
+bool PassthroughArbiter::SendLocal(const ACFramer &frame, uint32_t now) {
+  if (!CanSendLocal(now)) {
+    return false;
+  }
+  write_board_(frame.buffer(), frame.buffer_pos());
+  board_framer_.Reset();
+  owner_ = Owner::Local;
+  request_sent_at_ = now;
+  return true;
+}
+
+void PassthroughArbiter::ReleaseHeldBytes(uint32_t now) {
+  const size_t len = held_len_;
+  held_len_ = 0;
+  for (size_t i = 0; i < len; ++i) {
+    ForwardToBoard(held_[i], now);
+  }
+}
+
+void PassthroughArbiter::ForwardToBoard(uint8_t c, uint32_t now) {
+  write_board_(&c, 1);
+
+  // Snoop just enough to know when the app has a request outstanding. Anything
+  // that isn't a frame (e.g. the module's AT replies) passes straight through.
+  if (!module_framer_.FrameData(c)) {
+    module_framer_.Reset();
+    return;
+  }
+  if (module_framer_.HasFullFrame()) {
+    num_app_frames_++;
+    owner_ = Owner::App;
+    request_sent_at_ = now;
+    board_framer_.Reset();
+    module_framer_.Reset();
+  }
+}
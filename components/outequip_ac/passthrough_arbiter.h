@@ -0,0 +1,101 @@
+#ifndef __PASSTHROUGH_ARBITER_H__
+#define __PASSTHROUGH_ARBITER_H__
+
+#include "ac_framer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+// Sits between the control board and the original Bluetooth module, forwarding
+// traffic both ways while slotting in our own requests during idle gaps.
+//
+// The protocol allows only one outstanding request, so the arbiter tracks who
+// owns the board: while the app owns it, board replies are forwarded to the
+// module; while we own it, replies are consumed locally and any bytes the
+// module sends meanwhile are held back until our reply arrives. Every frame
+// the board sends is reported, so the app's traffic updates our state too.
+class PassthroughArbiter {
+public:
+  enum class Owner : uint8_t { None, App, Local };
+
+  // Time to wait for the board to answer before a request is presumed lost.
+  static const uint32_t kResponseTimeoutMs = 1000;
+  // Quiet time required from the module before we start a request, so an app
+  // that's mid-conversation gets to go first.
+  static const uint32_t kIdleGapMs = 50;
+  // Module bytes we can hold back while waiting for our own reply.
+  static const size_t kMaxHeldBytes = 3 * ACFramer::kMaxFrameSize;
+
+  using WriteFn = std::function<void(const uint8_t *data, size_t len)>;
+  /**
+   * @brief Called for every complete frame from the board.
+   *
+   * @param frame The board's frame.
+   * @param local true if it answers a request we sent, false if it answers the
+   * app (or was unsolicited) and was forwarded to the module.
+   */
+  using FrameFn = std::function<void(const ACFramer &frame, bool local)>;
+  /**
+   * @brief Called for each board byte that breaks a frame, or is neither
+   * part of a frame nor AT text for the module.
+   *
+   * @param c The byte.
+   * @param frame_len Length of the partial frame it broke, or 0 for a stray
+   * byte outside any frame.
+   */
+  using ErrorFn = std::function<void(uint8_t c, size_t frame_len)>;
+
+  PassthroughArbiter(WriteFn write_board, WriteFn write_module,
+                     FrameFn on_board_frame);
+
+  void OnBoardByte(uint8_t c, uint32_t now);
+  void OnModuleByte(uint8_t c, uint32_t now);
+  // Expire requests the board never answered.
+  void Poll(uint32_t now);
+
+  bool CanSendLocal(uint32_t now) const;
+  /**
+   * @brief Send one of our own frames to the board if the link is idle.
+   *
+   * @return false if the app currently has the floor.
+   */
+  bool SendLocal(const ACFramer &frame, uint32_t now);
+
+  void set_on_board_error(ErrorFn on_board_error) {
+    on_board_error_ = std::move(on_board_error);
+  }
+
+  Owner owner() const { return owner_; }
+  uint32_t num_app_frames() const { return num_app_frames_; }
+  uint32_t num_held_bytes_dropped() const { return num_held_bytes_dropped_; }
+  uint32_t num_frames_failed() const { return num_frames_failed_; }
+  uint32_t num_spurious_bytes_rx() const { return num_spurious_bytes_rx_; }
+
+private:
+  void ReleaseHeldBytes(uint32_t now);
+  void ForwardToBoard(uint8_t c, uint32_t now);
+
+  WriteFn write_board_;
+  WriteFn write_module_;
+  FrameFn on_board_frame_;
+  ErrorFn on_board_error_;
+
+  ACFramer board_framer_;
+  ACFramer module_framer_;
+
+  Owner owner_{Owner::None};
+  uint32_t request_sent_at_{0};
+  uint32_t last_module_byte_at_{0};
+
+  uint8_t held_[kMaxHeldBytes];
+  size_t held_len_{0};
+
+  uint32_t num_app_frames_{0};
+  uint32_t num_held_bytes_dropped_{0};
+  uint32_t num_frames_failed_{0};
+  uint32_t num_spurious_bytes_rx_{0};
+};
+
+#endif // __PASSTHROUGH_ARBITER_H__
@@ -0,0 +1,80 @@
+#include "rule_engine.h"
+
+size_t RuleEngine::AddThreshold(Input input, float threshold, bool above,
+                                float hysteresis) {
+  Rule rule;
+  rule.input = input;
+  rule.threshold = threshold;
+  rule.hysteresis = hysteresis;
+  rule.above = above;
+  rule.schedule = false;
+  rules_.push_back(rule);
+  rules_by_input_[static_cast<size_t>(input)].push_back(rules_.size() - 1);
+  return rules_.size() - 1;
+}
+
+size_t RuleEngine::AddSchedule(uint16_t minute_of_day) {
+  Rule rule;
+  rule.input = Input::MinuteOfDay;
+  rule.threshold = minute_of_day;
+  rule.hysteresis = 0;
+  rule.above = false;
+  rule.schedule = true;
+  rules_.push_back(rule);
+  rules_by_input_[static_cast<size_t>(Input::MinuteOfDay)].push_back(
+      rules_.size() - 1);
+  return rules_.size() - 1;
+}
+
+void RuleEngine::SetInput(Input input, float value) {
+  const size_t i = static_cast<size_t>(input);
+  if (i >= kNumInputs || std::isnan(value) || inputs_[i] == value) {
+    return;
+  }
+  const std::optional<float> previous = inputs_[i];
+  inputs_[i] = value;
+  for (size_t idx : rules_by_input_[i]) {
+    Evaluate(idx, previous, value);
+  }
+}
+
+void RuleEngine::Evaluate(size_t idx, std::optional<float> previous,
+                          float value) {
+  Rule &rule = rules_[idx];
+
+  if (rule.schedule) {
+    // The first reading only establishes where the clock is.
+    if (!previous.has_value()) {
+      return;
+    }
+    const float at = rule.threshold;
+    const bool passed = *previous <= value
+                            ? (*previous < at && at <= value)
+                            // Wrapped past midnight.
+                            : (*previous < at || at <= value);
+    if (passed) {
+      Fire(idx, false);
+    }
+    return;
+  }
+
+  bool active;
+  if (rule.active) {
+    active = rule.above ? value > rule.threshold - rule.hysteresis
+                        : value < rule.threshold + rule.hysteresis;
+  } else {
+    active = rule.above ? value > rule.threshold : value < rule.threshold;
+  }
+  if (active == rule.active) {
+    return;
+  }
+  rule.active = active;
+  Fire(idx, !active);
+}
+
+void RuleEngine::Fire(size_t idx, bool cleared) {
+  const Action &action = cleared ? rules_[idx].on_clear : rules_[idx].then;
+  if (action_fn_ && !action.empty()) {
+    action_fn_(idx, cleared, action);
+  }
+}
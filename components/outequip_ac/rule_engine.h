@@ -0,0 +1,95 @@
+#ifndef __RULE_ENGINE_H__
+#define __RULE_ENGINE_H__
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <vector>
+
+// Local control rules evaluated over decoded board state, so setbacks and
+// protection keep working without Home Assistant or WiFi.
+//
+// Rules are edge-triggered: a threshold rule fires its action once when its
+// condition becomes true and its clear action once when it stops being true;
+// a schedule rule fires when the clock passes its time of day. Only the rules
+// reading an input are evaluated when that input changes.
+class RuleEngine {
+public:
+  enum class Input : uint8_t {
+    Voltage = 0,
+    IntakeTemp,
+    // Local time as minutes since midnight.
+    MinuteOfDay,
+  };
+  static const size_t kNumInputs = 3;
+
+  // What to do when a rule fires. Mode and fan mode hold climate enum values,
+  // opaque to the engine; negative and NAN mean "leave unchanged".
+  struct Action {
+    int16_t mode{-1};
+    int16_t fan_mode{-1};
+    float target_temperature{NAN};
+
+    bool empty() const {
+      return mode < 0 && fan_mode < 0 && std::isnan(target_temperature);
+    }
+  };
+
+  using ActionFn =
+      std::function<void(size_t rule, bool cleared, const Action &action)>;
+
+  void set_action_fn(ActionFn action_fn) { action_fn_ = std::move(action_fn); }
+
+  /**
+   * @brief Add a rule that is active while input is above (or below)
+   * threshold. Once active, it only clears after the input comes back past
+   * threshold by hysteresis.
+   *
+   * @return The rule's index.
+   */
+  size_t AddThreshold(Input input, float threshold, bool above,
+                      float hysteresis);
+  /**
+   * @brief Add a rule that fires each day when the clock reaches minute_of_day.
+   *
+   * @return The rule's index.
+   */
+  size_t AddSchedule(uint16_t minute_of_day);
+
+  Action &then(size_t rule) { return rules_[rule].then; }
+  Action &on_clear(size_t rule) { return rules_[rule].on_clear; }
+
+  /**
+   * @brief Update an input, firing any of its rules whose state changes.
+   * Setting an input to its current value does nothing.
+   */
+  void SetInput(Input input, float value);
+
+  bool IsActive(size_t rule) const { return rules_[rule].active; }
+  size_t num_rules() const { return rules_.size(); }
+
+private:
+  struct Rule {
+    Input input;
+    float threshold;
+    float hysteresis;
+    bool above;
+    bool schedule;
+    bool active{false};
+    Action then;
+    Action on_clear;
+  };
+
+  void Evaluate(size_t idx, std::optional<float> previous, float value);
+  void Fire(size_t idx, bool cleared);
+
+  std::vector<Rule> rules_;
+  std::vector<size_t> rules_by_input_[kNumInputs];
+  std::optional<float> inputs_[kNumInputs];
+  ActionFn action_fn_;
+};
+
+#endif // __RULE_ENGINE_H__
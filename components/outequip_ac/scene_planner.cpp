@@ -0,0 +1,111 @@
+#include "scene_planner.h"
+
+constexpr ACFramer::Key ScenePlanner::kKeys[];
+
+size_t ScenePlanner::IndexOf(ACFramer::Key key) {
+  for (size_t i = 0; i < kNumKeys; ++i) {
+    if (kKeys[i] == key) {
+      return i;
+    }
+  }
+  return kNumKeys;
+}
+
+bool ScenePlanner::IsFireAndForget(ACFramer::Key key) {
+  return key == ACFramer::Key::Light;
+}
+
+uint16_t ScenePlanner::Normalize(ACFramer::Key key, uint16_t value) {
+  // The display is set with OnOffValue, but polls report 0 for on.
+  if (key == ACFramer::Key::LCD && value == 0) {
+    return static_cast<uint16_t>(ACFramer::OnOffValue::On);
+  }
+  return value;
+}
+
+void ScenePlanner::Scene::Set(ACFramer::Key key, uint16_t value) {
+  const size_t idx = IndexOf(key);
+  if (idx < kNumKeys) {
+    values_[idx] = value;
+  }
+}
+
+void ScenePlanner::Scene::Clear(ACFramer::Key key) {
+  const size_t idx = IndexOf(key);
+  if (idx < kNumKeys) {
+    values_[idx].reset();
+  }
+}
+
+std::optional<uint16_t> ScenePlanner::Scene::Get(ACFramer::Key key) const {
+  const size_t idx = IndexOf(key);
+  return idx < kNumKeys ? values_[idx] : std::nullopt;
+}
+
+void ScenePlanner::OnBoardValue(ACFramer::Key key, uint16_t value) {
+  const size_t idx = IndexOf(key);
+  if (idx >= kNumKeys || IsFireAndForget(key)) {
+    return;
+  }
+  value = Normalize(key, value);
+  confirmed_[idx] = value;
+  // A stale reply to an earlier poll leaves the step pending.
+  if (pending_[idx] == value) {
+    pending_[idx].reset();
+  }
+}
+
+void ScenePlanner::OnWritten(ACFramer::Key key, uint16_t value) {
+  const size_t idx = IndexOf(key);
+  if (idx < kNumKeys && IsFireAndForget(key)) {
+    confirmed_[idx] = value;
+  }
+}
+
+std::vector<ScenePlanner::Step> ScenePlanner::Plan(const Scene &scene) {
+  std::vector<Step> steps;
+  bool powering_on = false;
+  for (size_t i = 0; i < kNumKeys; ++i) {
+    const auto want = scene.Get(kKeys[i]);
+    if (!want.has_value()) {
+      continue;
+    }
+    if (IsFireAndForget(kKeys[i])) {
+      steps.push_back(Step{kKeys[i], *want});
+      continue;
+    }
+    // Compare against where the key is headed, not just where it is.
+    const auto known = pending_[i].has_value() ? pending_[i] : confirmed_[i];
+    const bool lcd_reset = powering_on && kKeys[i] == ACFramer::Key::LCD;
+    if (known == want && !lcd_reset) {
+      continue;
+    }
+    pending_[i] = want;
+    steps.push_back(Step{kKeys[i], *want});
+    if (kKeys[i] == ACFramer::Key::Power &&
+        *want == static_cast<uint16_t>(ACFramer::OnOffValue::On)) {
+      powering_on = true;
+    }
+  }
+  return steps;
+}
+
+std::optional<uint16_t> ScenePlanner::confirmed(ACFramer::Key key) const {
+  const size_t idx = IndexOf(key);
+  return idx < kNumKeys ? confirmed_[idx] : std::nullopt;
+}
+
+bool ScenePlanner::HasPending() const {
+  for (const auto &p : pending_) {
+    if (p.has_value()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void ScenePlanner::ClearPending() {
+  for (auto &p : pending_) {
+    p.reset();
+  }
+}
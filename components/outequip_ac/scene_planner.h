@@ -0,0 +1,85 @@
+#ifndef __SCENE_PLANNER_H__
+#define __SCENE_PLANNER_H__
+
+#include "ac_framer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+// Turns a desired board state into the fewest frames needed to reach it.
+//
+// The planner tracks what the board last reported for each scene key, plus
+// values we've sent that the board hasn't confirmed yet. A plan skips keys
+// already at (or on their way to) the wanted value, and orders the rest so
+// settings land before the unit powers on and the display is touched last.
+// Powering on turns the display back on, so a plan that powers on always
+// sets the display afterwards.
+//
+// Light can't be read back (the board almost always reports 1) and isn't
+// polled, so it is fire-and-forget: it is always sent, never left pending, and
+// taken as confirmed once its frame is written.
+class ScenePlanner {
+public:
+  // Scene keys, in the order their frames are sent.
+  static constexpr ACFramer::Key kKeys[] = {
+      ACFramer::Key::Mode,  ACFramer::Key::SetTemperature,
+      ACFramer::Key::FanSpeed, ACFramer::Key::Power,
+      ACFramer::Key::LCD,   ACFramer::Key::Light,
+  };
+  static const size_t kNumKeys = sizeof(kKeys) / sizeof(*kKeys);
+
+  struct Step {
+    ACFramer::Key key;
+    uint16_t value;
+  };
+
+  // Wanted board values; keys left unset are left alone.
+  class Scene {
+  public:
+    void Set(ACFramer::Key key, uint16_t value);
+    void Clear(ACFramer::Key key);
+    std::optional<uint16_t> Get(ACFramer::Key key) const;
+
+  private:
+    std::optional<uint16_t> values_[kNumKeys];
+  };
+
+  /**
+   * @brief Record a value the board reported, confirming a pending step if it
+   * matches.
+   */
+  void OnBoardValue(ACFramer::Key key, uint16_t value);
+  /**
+   * @brief Record a frame written to the board; fire-and-forget keys are
+   * confirmed by this alone.
+   */
+  void OnWritten(ACFramer::Key key, uint16_t value);
+
+  /**
+   * @brief Plan the frames needed to reach scene. They are considered pending
+   * until the board reports the sent values.
+   */
+  std::vector<Step> Plan(const Scene &scene);
+
+  // The value the board reported last, if any.
+  std::optional<uint16_t> confirmed(ACFramer::Key key) const;
+  bool HasPending() const;
+  // Forget unconfirmed steps, e.g. after they timed out.
+  void ClearPending();
+
+  // Map a key's reported value onto the value we'd send to set it; the
+  // board reports some keys differently from how they're written.
+  static uint16_t Normalize(ACFramer::Key key, uint16_t value);
+  // Returns kNumKeys for keys that aren't part of a scene.
+  static size_t IndexOf(ACFramer::Key key);
+  // Keys whose reported value can't be trusted.
+  static bool IsFireAndForget(ACFramer::Key key);
+
+private:
+  std::optional<uint16_t> confirmed_[kNumKeys];
+  std::optional<uint16_t> pending_[kNumKeys];
+};
+
+#endif // __SCENE_PLANNER_H__
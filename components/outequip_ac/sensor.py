@@ -1,7 +1,7 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
 from esphome.components import sensor
-from esphome.const import CONF_ID, DEVICE_CLASS_VOLTAGE, STATE_CLASS_MEASUREMENT, UNIT_VOLT, UNIT_CELSIUS, DEVICE_CLASS_TEMPERATURE, DEVICE_CLASS_CURRENT, UNIT_AMPERE
+from esphome.const import CONF_ID, DEVICE_CLASS_VOLTAGE, STATE_CLASS_MEASUREMENT, UNIT_VOLT, UNIT_CELSIUS, DEVICE_CLASS_TEMPERATURE, DEVICE_CLASS_CURRENT, UNIT_AMPERE, UNIT_MILLISECOND, UNIT_PERCENT, ENTITY_CATEGORY_DIAGNOSTIC
 from . import outequip_ac_ns, OutEquipAC, CONF_OUTEQUIP_AC_ID
 
 DEPENDENCIES = ["outequip_ac"]
@@ -13,6 +13,64 @@ CONF_UNDERVOLT = "undervolt"
 CONF_OVERVOLT = "overvolt"
 CONF_AMPERAGE = "amperage"
 
+# Results of the link benchmark button; setter suffix -> schema.
+BENCHMARK_SENSORS = {
+    "benchmark_frame_rate": sensor.sensor_schema(
+        unit_of_measurement="frames/s",
+        accuracy_decimals=1,
+        state_class=STATE_CLASS_MEASUREMENT,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        icon="mdi:speedometer",
+    ),
+    "benchmark_rtt_median": sensor.sensor_schema(
+        unit_of_measurement=UNIT_MILLISECOND,
+        accuracy_decimals=0,
+        state_class=STATE_CLASS_MEASUREMENT,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        icon="mdi:timer-outline",
+    ),
+    "benchmark_rtt_p95": sensor.sensor_schema(
+        unit_of_measurement=UNIT_MILLISECOND,
+        accuracy_decimals=0,
+        state_class=STATE_CLASS_MEASUREMENT,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        icon="mdi:timer-outline",
+    ),
+    "benchmark_rtt_max": sensor.sensor_schema(
+        unit_of_measurement=UNIT_MILLISECOND,
+        accuracy_decimals=0,
+        state_class=STATE_CLASS_MEASUREMENT,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        icon="mdi:timer-alert-outline",
+    ),
+    "benchmark_failure_rate": sensor.sensor_schema(
+        unit_of_measurement=UNIT_PERCENT,
+        accuracy_decimals=1,
+        state_class=STATE_CLASS_MEASUREMENT,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        icon="mdi:alert-circle-outline",
+    ),
+    "benchmark_spurious_bytes": sensor.sensor_schema(
+        accuracy_decimals=0,
+        state_class=STATE_CLASS_MEASUREMENT,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        icon="mdi:alert-circle-outline",
+    ),
+    "benchmark_timeouts": sensor.sensor_schema(
+        accuracy_decimals=0,
+        state_class=STATE_CLASS_MEASUREMENT,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        icon="mdi:timer-sand-empty",
+    ),
+    # Replies slower than the 128 ms RTT histogram.
+    "benchmark_slow_replies": sensor.sensor_schema(
+        accuracy_decimals=0,
+        state_class=STATE_CLASS_MEASUREMENT,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        icon="mdi:timer-alert-outline",
+    ),
+}
+
 CONFIG_SCHEMA = cv.Schema({
     cv.GenerateID(CONF_OUTEQUIP_AC_ID): cv.use_id(OutEquipAC),
     cv.Optional(CONF_INTAKE_TEMP): sensor.sensor_schema(
@@ -57,31 +115,45 @@ CONFIG_SCHEMA = cv.Schema({
         state_class=STATE_CLASS_MEASUREMENT,
         icon="mdi:current-dc",
     ),
-})
+}).extend({cv.Optional(key): schema for key, schema in BENCHMARK_SENSORS.items()})
 
+# Each configured sensor emits a define that adds its key to the compile-time
+# poll table and compiles in its decode branch; see kQueryKeys.
 async def to_code(config):
     parent = await cg.get_variable(config[CONF_OUTEQUIP_AC_ID])
     
     if CONF_INTAKE_TEMP in config:
+        cg.add_define("USE_OUTEQUIP_AC_INTAKE_TEMP_SENSOR")
         sens = await sensor.new_sensor(config[CONF_INTAKE_TEMP])
         cg.add(parent.set_intake_temp_sensor(sens))
         
     if CONF_OUTLET_TEMP in config:
+        cg.add_define("USE_OUTEQUIP_AC_OUTLET_TEMP_SENSOR")
         sens = await sensor.new_sensor(config[CONF_OUTLET_TEMP])
         cg.add(parent.set_outlet_temp_sensor(sens))
         
     if CONF_VOLTAGE in config:
+        cg.add_define("USE_OUTEQUIP_AC_VOLTAGE_SENSOR")
         sens = await sensor.new_sensor(config[CONF_VOLTAGE])
         cg.add(parent.set_voltage_sensor(sens))
         
     if CONF_UNDERVOLT in config:
+        cg.add_define("USE_OUTEQUIP_AC_UNDERVOLT_SENSOR")
         sens = await sensor.new_sensor(config[CONF_UNDERVOLT])
         cg.add(parent.set_undervolt_sensor(sens))
 
     if CONF_OVERVOLT in config:
+        cg.add_define("USE_OUTEQUIP_AC_OVERVOLT_SENSOR")
         sens = await sensor.new_sensor(config[CONF_OVERVOLT])
         cg.add(parent.set_overvolt_sensor(sens))
 
     if CONF_AMPERAGE in config:
+        cg.add_define("USE_OUTEQUIP_AC_AMPERAGE_SENSOR")
         sens = await sensor.new_sensor(config[CONF_AMPERAGE])
         cg.add(parent.set_amperage_sensor(sens))
+
+    for key in BENCHMARK_SENSORS:
+        if key in config:
+            cg.add_define("USE_OUTEQUIP_AC_BENCHMARK")
+            sens = await sensor.new_sensor(config[key])
+            cg.add(getattr(parent, f"set_{key}_sensor")(sens))
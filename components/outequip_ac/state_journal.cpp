@@ -0,0 +1,44 @@
+#include "state_journal.h"
+
+#include <cstring>
+
+StateJournal::StateJournal(uint32_t epoch) : epoch_(epoch) {
+  memset(values_, 0, sizeof(values_));
+  memset(versions_, 0, sizeof(versions_));
+}
+
+bool StateJournal::Set(Field f, float value) {
+  const size_t idx = static_cast<size_t>(f);
+  if (idx >= kNumFields) {
+    return false;
+  }
+  if (versions_[idx] != 0 && values_[idx] == value) {
+    return false;
+  }
+  values_[idx] = value;
+  versions_[idx] = ++version_;
+  return true;
+}
+
+bool StateJournal::Has(Field f) const { return GetVersion(f) != 0; }
+
+float StateJournal::Get(Field f) const {
+  const size_t idx = static_cast<size_t>(f);
+  return idx < kNumFields ? values_[idx] : 0;
+}
+
+uint32_t StateJournal::GetVersion(Field f) const {
+  const size_t idx = static_cast<size_t>(f);
+  return idx < kNumFields ? versions_[idx] : 0;
+}
+
+bool StateJournal::CanServeDelta(uint32_t epoch, uint32_t since) const {
+  if (epoch != epoch_ || since == 0 || since > version_) {
+    return false;  // Unknown or future state, client must start over.
+  }
+  return version_ - since <= kMaxDeltaSpan;
+}
+
+bool StateJournal::ChangedSince(Field f, uint32_t since) const {
+  return GetVersion(f) > since;
+}
@@ -0,0 +1,76 @@
+#ifndef __STATE_JOURNAL_H__
+#define __STATE_JOURNAL_H__
+
+#include <cstddef>
+#include <cstdint>
+
+// Keeps the last published value of each UI-facing field alongside the
+// journal version at which it last changed, so reconnecting clients can fetch
+// only what changed since they last synced.
+class StateJournal {
+public:
+  enum class Field : uint8_t {
+    Mode = 0,
+    FanMode,
+    TargetTemp,
+    IntakeTemp,
+    OutletTemp,
+  };
+  static const size_t kNumFields = 5;
+
+  // Deltas spanning more versions than this are answered with a full snapshot
+  // instead; by then nearly every field has changed anyway.
+  static const uint32_t kMaxDeltaSpan = 64;
+
+  static constexpr const char *FieldToString(Field f) {
+    switch (f) {
+    case Field::Mode:
+      return "mode";
+    case Field::FanMode:
+      return "fan_mode";
+    case Field::TargetTemp:
+      return "target_temperature";
+    case Field::IntakeTemp:
+      return "intake_temp";
+    case Field::OutletTemp:
+      return "outlet_temp";
+    }
+    return "invalid";
+  }
+
+  /**
+   * @param epoch Identifies this journal instance (e.g. random per boot) so
+   * clients holding versions from a previous boot get a full snapshot.
+   */
+  explicit StateJournal(uint32_t epoch = 0);
+
+  /**
+   * @brief Record a new value for a field.
+   *
+   * @return true if the value changed and the journal version was bumped.
+   */
+  bool Set(Field f, float value);
+
+  bool Has(Field f) const;
+  float Get(Field f) const;
+  uint32_t GetVersion(Field f) const;
+
+  /**
+   * @brief Whether a client at (epoch, since) can be brought up to date with a
+   * delta, as opposed to needing a full snapshot.
+   */
+  bool CanServeDelta(uint32_t epoch, uint32_t since) const;
+  bool ChangedSince(Field f, uint32_t since) const;
+
+  uint32_t epoch() const { return epoch_; }
+  uint32_t version() const { return version_; }
+
+private:
+  uint32_t epoch_;
+  uint32_t version_{0};
+  float values_[kNumFields];
+  // 0 means the field has never been set.
+  uint32_t versions_[kNumFields];
+};
+
+#endif // __STATE_JOURNAL_H__
@@ -29,11 +29,14 @@ CONFIG_SCHEMA = cv.Schema({
     ).extend(cv.COMPONENT_SCHEMA),
 })
 
+# As with sensors, each configured switch emits a define so unused keys are
+# never polled and their decode branches are compiled out.
 async def to_code(config):
     parent = await cg.get_variable(config[CONF_OUTEQUIP_AC_ID])
     
     if CONF_LCD in config:
         conf = config[CONF_LCD]
+        cg.add_define("USE_OUTEQUIP_AC_LCD_SWITCH")
         var = await switch.new_switch(conf)
         await cg.register_component(var, conf)
         cg.add(var.set_parent(parent))
@@ -42,6 +45,7 @@ async def to_code(config):
 
     if CONF_SWING in config:
         conf = config[CONF_SWING]
+        cg.add_define("USE_OUTEQUIP_AC_SWING_SWITCH")
         var = await switch.new_switch(conf)
         await cg.register_component(var, conf)
         cg.add(var.set_parent(parent))
@@ -50,6 +54,7 @@ async def to_code(config):
 
     if CONF_LIGHT in config:
         conf = config[CONF_LIGHT]
+        cg.add_define("USE_OUTEQUIP_AC_LIGHT_SWITCH")
         if CONF_RESTORE_MODE not in conf:
             conf[CONF_RESTORE_MODE] = "RESTORE_DEFAULT_OFF"
         var = await switch.new_switch(conf)
@@ -0,0 +1,235 @@
+#include "telemetry_ring.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+void TelemetryRing::EnableFlash(size_t num_slots, LoadFn load, SaveFn save,
+                                SaveSentSeqFn save_sent_seq,
+                                uint32_t sent_seq) {
+  num_slots_ = num_slots;
+  load_ = std::move(load);
+  save_ = std::move(save);
+  save_sent_seq_ = std::move(save_sent_seq);
+  last_seq_ = sent_seq;
+
+  slots_.clear();
+  for (size_t i = 0; i < num_slots_; ++i) {
+    if (!load_(i, &draining_) || draining_.seq == 0) {
+      continue;
+    }
+    last_seq_ = std::max(last_seq_, draining_.seq);
+    if (draining_.seq > sent_seq && draining_.count > 0) {
+      slots_.push_back({i, draining_.seq, draining_.count, true});
+    }
+  }
+  std::sort(slots_.begin(), slots_.end(),
+            [](const Slot &a, const Slot &b) { return a.seq < b.seq; });
+  if (!slots_.empty()) {
+    next_slot_ = (slots_.back().index + 1) % num_slots_;
+  }
+  draining_left_ = 0;
+}
+
+void TelemetryRing::Push(const std::string &line, uint32_t now_ms,
+                         uint32_t epoch) {
+  Record record{now_ms, epoch, line};
+  ram_bytes_ += RamSize(record);
+  ram_.push_back(std::move(record));
+  while (ram_bytes_ > capacity_ && !ram_.empty()) {
+    if (num_slots_ > 0) {
+      Spill(ram_.front());
+    } else {
+      num_dropped_++;
+    }
+    ram_bytes_ -= RamSize(ram_.front());
+    ram_.pop_front();
+  }
+}
+
+void TelemetryRing::Spill(const Record &record) {
+  const size_t size = kRecordHeaderSize + record.line.size();
+  if (size > kBlockSize) {
+    num_dropped_++;
+    return;
+  }
+  // Flash is only written a whole block at a time.
+  if (staging_.used + size > kBlockSize) {
+    FlushStaging();
+  }
+  uint8_t *p = staging_.data + staging_.used;
+  const uint16_t len = record.line.size();
+  std::memcpy(p, &record.epoch, 4);
+  std::memcpy(p + 4, &record.at_ms, 4);
+  std::memcpy(p + 8, &len, 2);
+  std::memcpy(p + kRecordHeaderSize, record.line.data(), len);
+  staging_.used += size;
+  staging_.count++;
+  num_spilled_++;
+}
+
+void TelemetryRing::FlushStaging() {
+  if (staging_.count == 0) {
+    return;
+  }
+  size_t index = next_slot_;
+  if (slots_.size() >= num_slots_) {
+    // Out of slots: the oldest unsent block makes way.
+    index = slots_.front().index;
+    num_dropped_ += slots_.front().count;
+    slots_.pop_front();
+  } else {
+    // Rotate through free slots to spread the writes.
+    auto in_use = [this](size_t i) {
+      return std::any_of(slots_.begin(), slots_.end(),
+                         [i](const Slot &slot) { return slot.index == i; });
+    };
+    while (in_use(index)) {
+      index = (index + 1) % num_slots_;
+    }
+  }
+  staging_.seq = ++last_seq_;
+  if (save_(index, staging_)) {
+    slots_.push_back({index, staging_.seq, staging_.count, false});
+    next_slot_ = (index + 1) % num_slots_;
+  } else {
+    num_flash_write_failures_++;
+    num_dropped_ += staging_.count;
+  }
+  staging_.used = 0;
+  staging_.count = 0;
+}
+
+bool TelemetryRing::TakeFromBlock(Record *record) {
+  while (draining_left_ > 0) {
+    draining_left_--;
+    const uint8_t *p = draining_.data + draining_pos_;
+    uint16_t len = 0;
+    if (draining_pos_ + kRecordHeaderSize <= draining_.used) {
+      std::memcpy(&len, p + 8, 2);
+    }
+    if (draining_pos_ + kRecordHeaderSize + len > draining_.used) {
+      // Corrupt block; skip the rest of it.
+      num_dropped_ += draining_left_ + 1;
+      draining_left_ = 0;
+      break;
+    }
+    std::memcpy(&record->epoch, p, 4);
+    std::memcpy(&record->at_ms, p + 4, 4);
+    record->line.assign(reinterpret_cast<const char *>(p) + kRecordHeaderSize,
+                        len);
+    draining_pos_ += kRecordHeaderSize + len;
+    if (draining_restored_ && record->epoch == 0) {
+      num_dropped_++;
+      continue;
+    }
+    return true;
+  }
+  return false;
+}
+
+bool TelemetryRing::TakeRecord(Record *record) {
+  if (!returned_.empty()) {
+    *record = std::move(returned_.front());
+    returned_.pop_front();
+    return true;
+  }
+  while (true) {
+    if (TakeFromBlock(record)) {
+      return true;
+    }
+    if (draining_seq_ != 0 && slots_.empty()) {
+      // Everything in flash is out; once delivered, one small write keeps
+      // it from being resent after a reboot.
+      unsaved_sent_seq_ = draining_seq_;
+      draining_seq_ = 0;
+    }
+    if (!slots_.empty()) {
+      const Slot slot = slots_.front();
+      slots_.pop_front();
+      if (!load_(slot.index, &draining_) || draining_.seq != slot.seq) {
+        num_dropped_ += slot.count;
+        continue;
+      }
+      draining_seq_ = slot.seq;
+      draining_restored_ = slot.restored;
+    } else if (staging_.count > 0) {
+      draining_ = staging_;
+      staging_.used = 0;
+      staging_.count = 0;
+      draining_restored_ = false;
+    } else {
+      break;
+    }
+    draining_pos_ = 0;
+    draining_left_ = draining_.count;
+  }
+
+  if (ram_.empty()) {
+    return false;
+  }
+  *record = std::move(ram_.front());
+  ram_bytes_ -= RamSize(*record);
+  ram_.pop_front();
+  return true;
+}
+
+std::string TelemetryRing::Format(const Record &record, uint32_t now_ms,
+                                  uint32_t epoch) {
+  uint32_t at = record.epoch;
+  if (at == 0 && epoch != 0) {
+    at = epoch - (now_ms - record.at_ms) / 1000;
+  }
+  if (at == 0) {
+    return record.line;
+  }
+  // Line protocol timestamps default to nanoseconds.
+  return record.line + " " + std::to_string(at) + "000000000";
+}
+
+std::string TelemetryRing::NextPacket(size_t max_bytes, uint32_t now_ms,
+                                      uint32_t epoch) {
+  Commit();
+  std::string packet;
+  Record record;
+  while (TakeRecord(&record)) {
+    const std::string line = Format(record, now_ms, epoch);
+    if (!packet.empty() && packet.size() + line.size() + 1 > max_bytes) {
+      returned_.push_front(std::move(record));
+      break;
+    }
+    packet += line;
+    packet += '\n';
+    in_flight_.push_back(std::move(record));
+  }
+  return packet;
+}
+
+void TelemetryRing::Commit() {
+  in_flight_.clear();
+  // Lines put back may still be from flash.
+  if (unsaved_sent_seq_ != 0 && returned_.empty()) {
+    if (!save_sent_seq_(unsaved_sent_seq_)) {
+      num_flash_write_failures_++;
+    }
+    unsaved_sent_seq_ = 0;
+  }
+}
+
+void TelemetryRing::Requeue() {
+  returned_.insert(returned_.begin(),
+                   std::make_move_iterator(in_flight_.begin()),
+                   std::make_move_iterator(in_flight_.end()));
+  in_flight_.clear();
+}
+
+bool TelemetryRing::empty() const { return size() == 0; }
+
+size_t TelemetryRing::size() const {
+  size_t size = ram_.size() + staging_.count + draining_left_ +
+                returned_.size();
+  for (const auto &slot : slots_) {
+    size += slot.count;
+  }
+  return size;
+}
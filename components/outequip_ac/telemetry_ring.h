@@ -0,0 +1,139 @@
+#ifndef __TELEMETRY_RING_H__
+#define __TELEMETRY_RING_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Holds InfluxDB lines while they can't be sent, and sends them later with
+// the time they were taken.
+//
+// Lines queue in RAM up to a byte budget. Past that, the oldest are either
+// dropped or, with flash enabled, packed into fixed-size blocks that are
+// written only once full, to a handful of slots in rotation. Draining is
+// oldest first: flash, then the block being packed, then RAM. The lines in
+// the last packet taken can be put back if it wasn't delivered.
+//
+// Each line is stamped with the wall clock when it's known, and otherwise
+// with uptime, which is turned into wall clock time once the clock is set.
+// Uptime stamps don't survive a reboot, so such lines are dropped when
+// restored from flash.
+class TelemetryRing {
+public:
+  static const size_t kBlockSize = 1024;
+  struct Block {
+    // Increases with every block written; 0 marks an unused slot.
+    uint32_t seq;
+    uint16_t used;
+    uint16_t count;
+    uint8_t data[kBlockSize];
+  };
+  using LoadFn = std::function<bool(size_t slot, Block *block)>;
+  // Save functions return false if the write failed.
+  using SaveFn = std::function<bool(size_t slot, const Block &block)>;
+  // Persists the seq of the newest block sent, so it isn't resent on boot.
+  using SaveSentSeqFn = std::function<bool(uint32_t seq)>;
+
+  explicit TelemetryRing(size_t capacity = 16384) : capacity_(capacity) {}
+  void set_capacity(size_t capacity) { capacity_ = capacity; }
+
+  /**
+   * @brief Spill to num_slots flash blocks instead of dropping. Blocks newer
+   * than sent_seq that are still in flash from before a reboot are queued.
+   */
+  void EnableFlash(size_t num_slots, LoadFn load, SaveFn save,
+                   SaveSentSeqFn save_sent_seq, uint32_t sent_seq);
+
+  /**
+   * @brief Queue a line taken at uptime now_ms, and at epoch seconds if the
+   * clock is set (0 otherwise).
+   */
+  void Push(const std::string &line, uint32_t now_ms, uint32_t epoch);
+
+  /**
+   * @brief Take the oldest lines, newline-terminated, up to max_bytes (a
+   * longer line goes alone). Each gets an InfluxDB timestamp, backfilled
+   * from the current time for lines stamped with uptime. Without a clock
+   * (epoch 0) those lines go out unstamped. Commits the previous packet.
+   */
+  std::string NextPacket(size_t max_bytes, uint32_t now_ms, uint32_t epoch);
+  // The last packet was delivered; its lines are gone for good.
+  void Commit();
+  // The last packet wasn't delivered; its lines go back to the front.
+  void Requeue();
+
+  bool empty() const;
+  // Bytes of RAM in use by queued lines, out of capacity().
+  size_t fill_bytes() const { return ram_bytes_; }
+  size_t capacity() const { return capacity_; }
+  // Lines queued in RAM and flash.
+  size_t size() const;
+  uint32_t num_dropped() const { return num_dropped_; }
+  uint32_t num_spilled() const { return num_spilled_; }
+  // A block that fails to save is dropped, and its lines counted as such.
+  uint32_t num_flash_write_failures() const {
+    return num_flash_write_failures_;
+  }
+
+private:
+  struct Record {
+    uint32_t at_ms;
+    uint32_t epoch;
+    std::string line;
+  };
+  // Encoded as epoch, uptime and length ahead of the line.
+  static const size_t kRecordHeaderSize = 10;
+
+  void Spill(const Record &record);
+  void FlushStaging();
+  bool TakeRecord(Record *record);
+  bool TakeFromBlock(Record *record);
+  static std::string Format(const Record &record, uint32_t now_ms,
+                            uint32_t epoch);
+  static size_t RamSize(const Record &record) {
+    return record.line.size() + sizeof(Record);
+  }
+
+  size_t capacity_;
+  std::deque<Record> ram_;
+  size_t ram_bytes_{0};
+  uint32_t num_dropped_{0};
+  uint32_t num_spilled_{0};
+  uint32_t num_flash_write_failures_{0};
+
+  // Flash spill state.
+  size_t num_slots_{0};
+  SaveFn save_;
+  SaveSentSeqFn save_sent_seq_;
+  LoadFn load_;
+  uint32_t last_seq_{0};
+  size_t next_slot_{0};
+  struct Slot {
+    size_t index;
+    uint32_t seq;
+    uint16_t count;
+    // Written before this boot, so uptime stamps in it are meaningless.
+    bool restored;
+  };
+  // Written and not yet sent, oldest first.
+  std::deque<Slot> slots_;
+  Block staging_{};
+  // The block being sent, from flash or staging.
+  Block draining_{};
+  size_t draining_pos_{0};
+  uint16_t draining_left_{0};
+  bool draining_restored_{false};
+  uint32_t draining_seq_{0};
+  // Put back: the line that didn't fit the last packet, or a whole
+  // undelivered packet. Sent before anything else.
+  std::deque<Record> returned_;
+  // Lines in the last packet, until it's committed or requeued.
+  std::vector<Record> in_flight_;
+  // Flash is drained up to this seq, to be saved once delivered.
+  uint32_t unsaved_sent_seq_{0};
+};
+
+#endif // __TELEMETRY_RING_H__
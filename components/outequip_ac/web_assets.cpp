@@ -0,0 +1,126 @@
+#include "web_assets.h"
+
+#ifdef USE_WEBSERVER
+
+#include <cstring>
+#include <string>
+
+namespace esphome {
+namespace outequip_ac {
+
+namespace {
+
+// Whether a comma-separated header value lists the given token. Good enough
+// for Accept-Encoding; q-values of zero are not honored.
+bool HeaderHasToken(const std::string &header, const char *token) {
+  const size_t len = strlen(token);
+  size_t pos = 0;
+  while ((pos = header.find(token, pos)) != std::string::npos) {
+    const bool start_ok = pos == 0 || header[pos - 1] == ' ' ||
+                          header[pos - 1] == ',';
+    const size_t end = pos + len;
+    const bool end_ok = end == header.size() || header[end] == ',' ||
+                        header[end] == ';' || header[end] == ' ';
+    if (start_ok && end_ok) {
+      return true;
+    }
+    pos = end;
+  }
+  return false;
+}
+
+// Whether an If-None-Match value lists etag, or is "*". Tags are compared
+// weakly, as RFC 9110 asks for If-None-Match: a W/ prefix is ignored.
+bool EtagListMatches(const std::string &header, const char *etag) {
+  const size_t etag_len = strlen(etag);
+  size_t pos = 0;
+  while (pos < header.size()) {
+    size_t end = header.find(',', pos);
+    if (end == std::string::npos) {
+      end = header.size();
+    }
+    size_t first = pos;
+    size_t last = end;
+    while (first < last && header[first] == ' ') {
+      first++;
+    }
+    while (last > first && header[last - 1] == ' ') {
+      last--;
+    }
+    if (header.compare(first, last - first, "*") == 0) {
+      return true;
+    }
+    if (header.compare(first, 2, "W/") == 0) {
+      first += 2;
+    }
+    if (header.compare(first, last - first, etag, etag_len) == 0) {
+      return true;
+    }
+    pos = end + 1;
+  }
+  return false;
+}
+
+} // namespace
+
+const WebAsset *
+OutEquipACAssetHandler::FindAsset(AsyncWebServerRequest *request) const {
+  const std::string url = request->url();
+  for (const auto &asset : assets_) {
+    if (url == asset.url) {
+      return &asset;
+    }
+  }
+  return nullptr;
+}
+
+bool OutEquipACAssetHandler::canHandle(AsyncWebServerRequest *request) const {
+  return request->method() == HTTP_GET && FindAsset(request) != nullptr;
+}
+
+void OutEquipACAssetHandler::handleRequest(AsyncWebServerRequest *request) {
+  const WebAsset *asset = FindAsset(request);
+  if (asset == nullptr || asset->variants.empty()) {
+    request->send(404);
+    return;
+  }
+
+  const std::string accept_encoding =
+      request->get_header("Accept-Encoding").value_or("");
+  const WebAssetVariant *variant = nullptr;
+  for (const auto &v : asset->variants) {
+    if (v.encoding[0] == '\0' || HeaderHasToken(accept_encoding, v.encoding)) {
+      variant = &v;
+      break;
+    }
+  }
+  if (variant == nullptr) {
+    // Only compressed copies are in flash, to save space; every browser
+    // accepts gzip.
+    request->send(406, "text/plain", "gzip required");
+    return;
+  }
+
+  const auto if_none_match = request->get_header("If-None-Match");
+  const bool not_modified = if_none_match.has_value() &&
+                            EtagListMatches(*if_none_match, variant->etag);
+
+  AsyncWebServerResponse *response =
+      not_modified ? request->beginResponse(304, asset->content_type, "")
+                   : request->beginResponse(200, asset->content_type,
+                                            variant->data, variant->size);
+  if (!not_modified && variant->encoding[0] != '\0') {
+    response->addHeader("Content-Encoding", variant->encoding);
+  }
+  if (asset->variants.size() > 1) {
+    response->addHeader("Vary", "Accept-Encoding");
+  }
+  response->addHeader("ETag", variant->etag);
+  response->addHeader("Cache-Control", asset->cache_control);
+  request->send(response);
+}
+
+} // namespace outequip_ac
+} // namespace esphome
+
+#endif // USE_WEBSERVER
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+
+#ifdef USE_WEBSERVER
+
+#include "esphome/components/web_server_base/web_server_base.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace esphome {
+namespace outequip_ac {
+
+// One precompressed representation of a web asset, stored in flash.
+struct WebAssetVariant {
+  // Content-Encoding value, or empty for identity.
+  const char *encoding;
+  const uint8_t *data;
+  size_t size;
+  // Strong ETag of these exact bytes, including quotes.
+  const char *etag;
+};
+
+struct WebAsset {
+  const char *url;
+  const char *content_type;
+  const char *cache_control;
+  // Ordered by preference. A client that accepts none of them gets 406; the
+  // build keeps an identity variant whenever gzip doesn't pay off.
+  std::vector<WebAssetVariant> variants;
+};
+
+// Serves web assets that were minified and precompressed at build time,
+// picking the best encoding the client accepts and answering conditional
+// requests with 304 Not Modified.
+class OutEquipACAssetHandler : public AsyncWebHandler {
+public:
+  void add_asset(const char *url, const char *content_type,
+                 const char *cache_control) {
+    assets_.push_back(WebAsset{url, content_type, cache_control, {}});
+  }
+  void add_variant(const char *encoding, const uint8_t *data, size_t size,
+                   const char *etag) {
+    assets_.back().variants.push_back(
+        WebAssetVariant{encoding, data, size, etag});
+  }
+
+  bool canHandle(AsyncWebServerRequest *request) const override;
+  void handleRequest(AsyncWebServerRequest *request) override;
+
+protected:
+  const WebAsset *FindAsset(AsyncWebServerRequest *request) const;
+
+  std::vector<WebAsset> assets_;
+};
+
+} // namespace outequip_ac
+} // namespace esphome
+
+#endif // USE_WEBSERVER
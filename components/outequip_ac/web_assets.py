@@ -0,0 +1,187 @@
+"""Build-time preprocessing for the web assets served by the component.
+
+Text assets get template substitution, inlined Material Design Icons and a
+conservative minification pass. Every asset is then precompressed so the
+device only ever streams bytes straight out of flash.
+"""
+
+import gzip
+import hashlib
+import logging
+import re
+
+from esphome import external_files
+from esphome.core import CORE
+
+try:
+    import brotli
+except ImportError:
+    brotli = None
+
+_LOGGER = logging.getLogger(__name__)
+
+DOMAIN = "outequip_ac"
+MDI_URL = "https://cdn.jsdelivr.net/npm/@mdi/svg@7/svg/{name}.svg"
+
+CONTENT_TYPES = {
+    ".html": "text/html",
+    ".js": "application/javascript",
+    ".css": "text/css",
+    ".json": "application/json",
+    ".webmanifest": "application/manifest+json",
+    ".svg": "image/svg+xml",
+    ".ico": "image/x-icon",
+    ".png": "image/png",
+}
+TEXT_TYPES = {
+    "text/html",
+    "application/javascript",
+    "text/css",
+    "application/json",
+    "application/manifest+json",
+    "image/svg+xml",
+}
+
+# Encoded variants must save at least this fraction to be worth storing.
+MIN_COMPRESSION_GAIN = 0.05
+
+_MDI_RE = re.compile(r'<svg([^>]*?)\s+data-mdi="([a-z0-9-]+)"([^>]*)>\s*</svg>')
+_MDI_PATH_RE = re.compile(r'<path[^>]*\sd="([^"]+)"')
+_BLOCK_RE = re.compile(r"(<(script|style)[^>]*>)(.*?)(</\2>)", re.S | re.I)
+
+
+def content_type_for(path):
+    for ext, content_type in CONTENT_TYPES.items():
+        if str(path).endswith(ext):
+            return content_type
+    return "application/octet-stream"
+
+
+def default_cache_control(content_type):
+    # Documents and the service worker must revalidate so a firmware update is
+    # picked up; a 304 makes that nearly free. Images change only with the
+    # firmware version, so let browsers keep them for a week.
+    if content_type.startswith("image/"):
+        return "public, max-age=604800"
+    return "no-cache"
+
+
+def _mdi_path(name):
+    path = external_files.compute_local_file_dir(DOMAIN) / "mdi" / f"{name}.svg"
+    if not path.is_file():
+        path.parent.mkdir(parents=True, exist_ok=True)
+        external_files.download_content(MDI_URL.format(name=name), path)
+    match = _MDI_PATH_RE.search(path.read_text(encoding="utf-8"))
+    if match is None:
+        raise ValueError(f"Could not find icon path in {path}")
+    return match.group(1)
+
+
+def inline_mdi_icons(text):
+    def repl(match):
+        return f'<svg{match.group(1)}{match.group(3)}><path d="{_mdi_path(match.group(2))}"/></svg>'
+
+    return _MDI_RE.sub(repl, text)
+
+
+def substitute(text, substitutions):
+    for key, value in substitutions.items():
+        text = text.replace("${" + key + "}", str(value))
+    return text
+
+
+def minify_css(css):
+    css = re.sub(r"/\*.*?\*/", "", css, flags=re.S)
+    css = re.sub(r"\s+", " ", css)
+    css = re.sub(r"\s*([{};,])\s*", r"\1", css)
+    return css.replace(";}", "}").strip()
+
+
+def minify_js(js):
+    # Only drop indentation, blank lines and whole-line comments. Newlines are
+    # kept so automatic semicolon insertion still behaves identically.
+    lines = []
+    for line in js.splitlines():
+        stripped = line.strip()
+        if not stripped or stripped.startswith("//"):
+            continue
+        lines.append(stripped)
+    return "\n".join(lines)
+
+
+def minify_html(html):
+    blocks = []
+
+    def stash(match):
+        body = match.group(3)
+        if match.group(2).lower() == "style":
+            body = minify_css(body)
+        else:
+            body = minify_js(body)
+        blocks.append(match.group(1) + body + match.group(4))
+        return f"\0{len(blocks) - 1}\0"
+
+    html = _BLOCK_RE.sub(stash, html)
+    html = re.sub(r"<!--(?!\[).*?-->", "", html, flags=re.S)
+    html = re.sub(r"\s+", " ", html)
+    html = re.sub(r"\0(\d+)\0", lambda m: blocks[int(m.group(1))], html)
+    return html.strip()
+
+
+def minify(text, content_type):
+    if content_type == "text/html":
+        return minify_html(text)
+    if content_type == "application/javascript":
+        return minify_js(text)
+    if content_type == "text/css":
+        return minify_css(text)
+    return text
+
+
+def etag_for(data):
+    return '"' + hashlib.sha256(data).hexdigest()[:16] + '"'
+
+
+def build_asset(path, content_type, substitutions):
+    """Return (identity_bytes, [(encoding, bytes), ...]) for an asset.
+
+    Variants are ordered by preference; an empty encoding means identity.
+    """
+    raw = path.read_bytes()
+    if content_type in TEXT_TYPES:
+        text = raw.decode("utf-8")
+        text = substitute(text, substitutions)
+        if content_type == "text/html":
+            text = inline_mdi_icons(text)
+        raw = minify(text, content_type).encode("utf-8")
+
+    variants = []
+    if brotli is not None:
+        variants.append(("br", brotli.compress(raw, quality=11)))
+    variants.append(("gzip", gzip.compress(raw, compresslevel=9, mtime=0)))
+    variants = [
+        (encoding, data)
+        for encoding, data in variants
+        if len(data) <= len(raw) * (1 - MIN_COMPRESSION_GAIN)
+    ]
+    if not any(encoding == "gzip" for encoding, _ in variants):
+        # Store identity instead; the handler answers 406 to a client that
+        # accepts none of the stored variants, so gzip must always be there
+        # when identity isn't.
+        variants = [v for v in variants if v[0] != "br"] + [("", raw)]
+
+    _LOGGER.info(
+        "Web asset %s: %d bytes -> %s",
+        path.name,
+        path.stat().st_size,
+        ", ".join(f"{e or 'identity'} {len(d)}" for e, d in variants),
+    )
+    return raw, variants
+
+
+def default_substitutions():
+    subs = {"name": CORE.name}
+    project = CORE.config.get("esphome", {}).get("project", {})
+    if "version" in project:
+        subs["version"] = project["version"]
+    return subs
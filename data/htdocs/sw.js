@@ -1,28 +1,61 @@
+// Cache name is tied to the firmware version the page registered us with, so a
+// firmware update starts from a fresh cache and old ones get cleaned up.
+const CACHE_VERSION = new URL(self.location).searchParams.get('v') || 'dev';
+const CACHE_NAME = 'outequip-ac-' + CACHE_VERSION;
+
 self.addEventListener('install', function(event) {
   self.skipWaiting(); // Force the updated service worker to activate immediately
   event.waitUntil(
-    caches.open('sw-cache').then(function(cache) {
+    caches.open(CACHE_NAME).then(function(cache) {
       return cache.addAll([
         'thermostat',
         'manifest.webmanifest',
         'apple-touch-icon.png',
-        'favicon.ico'
+        'favicon.ico',
+        'icon-96.png'
       ]);
     })
   );
 });
 
 self.addEventListener('activate', function(event) {
-  event.waitUntil(self.clients.claim()); // Force immediate page takeover
+  event.waitUntil(
+    caches.keys()
+      .then(keys => Promise.all(
+        keys.filter(key => key !== CACHE_NAME).map(key => caches.delete(key))
+      ))
+      .then(() => self.clients.claim()) // Force immediate page takeover
+  );
 });
- 
+
+// Map root fetches to the cached thermostat page, and tolerate trailing slashes
+function matchCached(request) {
+  return caches.match(request).then(response => {
+    if (response) return response;
+
+    try {
+      const urlObj = new URL(request.url);
+      if (urlObj.pathname === '/' || urlObj.pathname === '' || urlObj.pathname.endsWith('/')) {
+        return caches.match('thermostat');
+      }
+    } catch (e) {
+      console.error("Error matching offline root fallback:", e);
+    }
+
+    const urlStr = request.url;
+    const alternativeUrl = urlStr.endsWith('/') ? urlStr.slice(0, -1) : urlStr + '/';
+    return caches.match(alternativeUrl);
+  });
+}
+
 self.addEventListener("fetch", event => {
   const url = event.request.url;
-  
+
   // Completely bypass service worker for SSE stream, control commands, and dynamic APIs
   if (
     event.request.method !== 'GET' ||
     url.includes('/events') ||
+    url.includes('/outequip_ac/') ||
     url.includes('/climate/') ||
     url.includes('/number/') ||
     url.includes('/select/') ||
@@ -32,38 +65,24 @@ self.addEventListener("fetch", event => {
     return; // Direct browser network pass-through
   }
 
-  event.respondWith(
-    fetch(event.request)
-      .then(response => {
-        if (response && response.status === 200) {
-          const responseClone = response.clone();
-          caches.open("sw-cache").then(cache => {
-            cache.put(event.request, responseClone);
-          });
-        }
-        return response;
-      })
-      .catch(() => {
-        return caches.match(event.request).then(response => {
-          if (response) return response;
-          
-          // Map offline root fetches to the cached thermostat page
-          try {
-            const urlObj = new URL(event.request.url);
-            if (urlObj.pathname === '/' || urlObj.pathname === '' || urlObj.pathname.endsWith('/')) {
-              return caches.match('thermostat').then(fallbackRes => {
-                if (fallbackRes) return fallbackRes;
-                return caches.match(event.request);
-              });
-            }
-          } catch (e) {
-            console.error("Error matching offline root fallback:", e);
-          }
+  // Stale-while-revalidate: answer from cache immediately, refresh it in the background
+  const revalidate = fetch(event.request).then(response => {
+    if (response && response.status === 200) {
+      const responseClone = response.clone();
+      caches.open(CACHE_NAME).then(cache => {
+        cache.put(event.request, responseClone);
+      });
+    }
+    return response;
+  });
 
-          const urlStr = event.request.url;
-          const alternativeUrl = urlStr.endsWith('/') ? urlStr.slice(0, -1) : urlStr + '/';
-          return caches.match(alternativeUrl);
-        });
-      })
+  event.respondWith(
+    matchCached(event.request).then(cached => {
+      if (cached) {
+        event.waitUntil(revalidate.catch(() => {}));
+        return cached;
+      }
+      return revalidate.catch(() => matchCached(event.request));
+    })
   );
 });
@@ -0,0 +1,351 @@
+#!/usr/bin/env python3
+"""Load test for a host-platform build whose uart is the simulator's pty.
+
+Starts the simulated board, optionally launches the host binary, then runs
+many concurrent SSE and command clients against its web server and reports:
+
+- command latency: from POST /climate/<name>/set to the board seeing the
+  SetTemperature frame. Commands the firmware never sends (e.g. a setpoint
+  it already has) are reported as unmatched rather than paired with a later
+  frame;
+- SSE fan-out latency: from the board replying with a new intake temperature
+  to each /events client receiving it as a live `state` event. The full
+  dump each connection starts with isn't counted;
+- memory: resident set size of the device process over the run.
+
+Standard library only.
+"""
+
+import argparse
+import asyncio
+import json
+import statistics
+import time
+import urllib.parse
+
+import sim_board
+
+
+def percentiles(samples):
+    if not samples:
+        return "n=0"
+    s = sorted(samples)
+
+    def pct(p):
+        return s[min(len(s) - 1, int(p / 100 * len(s)))] * 1000
+
+    return (
+        f"n={len(s)} p50={pct(50):.1f}ms p90={pct(90):.1f}ms "
+        f"p99={pct(99):.1f}ms max={s[-1] * 1000:.1f}ms"
+    )
+
+
+def rss_kib(pid):
+    try:
+        with open(f"/proc/{pid}/status") as f:
+            for line in f:
+                if line.startswith("VmRSS:"):
+                    return int(line.split()[1])
+    except OSError:
+        pass
+    return None
+
+
+async def http_request(host, port, method, path, timeout=10):
+    reader, writer = await asyncio.wait_for(
+        asyncio.open_connection(host, port), timeout
+    )
+    try:
+        writer.write(
+            f"{method} {path} HTTP/1.1\r\nHost: {host}\r\n"
+            "Content-Length: 0\r\nConnection: close\r\n\r\n".encode()
+        )
+        await writer.drain()
+        status = await asyncio.wait_for(reader.readline(), timeout)
+        await asyncio.wait_for(reader.read(), timeout)
+        return int(status.split()[1])
+    finally:
+        writer.close()
+
+
+async def read_headers(reader):
+    headers = {}
+    while True:
+        line = await reader.readline()
+        if line in (b"\r\n", b"\n", b""):
+            return headers
+        name, _, value = line.decode().partition(":")
+        headers[name.strip().lower()] = value.strip()
+
+
+async def iter_body_lines(reader, chunked):
+    """Yield body lines, undoing chunked transfer encoding if needed."""
+    pending = b""
+    while True:
+        if chunked:
+            size_line = await reader.readline()
+            if not size_line:
+                return
+            size = int(size_line.split(b";")[0].strip() or b"0", 16)
+            if size == 0:
+                return
+            data = await reader.readexactly(size)
+            await reader.readline()
+        else:
+            data = await reader.read(4096)
+            if not data:
+                return
+        pending += data
+        *lines, pending = pending.split(b"\n")
+        for line in lines:
+            yield line.rstrip(b"\r").decode(errors="replace")
+
+
+class LoadTest:
+    def __init__(self, args):
+        self.args = args
+        url = urllib.parse.urlsplit(args.url)
+        self.host = url.hostname
+        self.port = url.port or 80
+        self.board = sim_board.SimBoard(
+            args.pty, on_frame=self.on_board_frame, on_reply=self.on_board_reply
+        )
+        self.stop = asyncio.Event()
+        # (board key, value) -> send time of the latest command awaiting
+        # that frame.
+        self.pending_commands = {}
+        self.command_latency = []
+        self.command_errors = 0
+        # Commands superseded, or still pending at the end, without a frame.
+        self.commands_unmatched = 0
+        # Intake temperature -> when the board first reported it.
+        self.intake_reported_at = {}
+        self.fanout_latency = []
+        self.sse_connected = 0
+        self.sse_dropped = 0
+        self.sse_bad_values = 0
+        self.task_errors = []
+        self.rss = []
+        self.proc = None
+
+    def on_board_frame(self, key, value, now):
+        if value == 0:
+            return
+        sent = self.pending_commands.pop((key, value), None)
+        if sent is not None:
+            self.command_latency.append(now - sent)
+
+    def expect_frame(self, key, value):
+        if (key, value) in self.pending_commands:
+            # The earlier command for this value never reached the board.
+            self.commands_unmatched += 1
+        self.pending_commands[(key, value)] = time.monotonic()
+
+    def on_board_reply(self, key, value, now):
+        if key == sim_board.INTAKE_TEMP:
+            self.intake_reported_at.setdefault(value, now)
+
+    async def wait_for_server(self, timeout=30):
+        deadline = time.monotonic() + timeout
+        while time.monotonic() < deadline:
+            try:
+                await http_request(self.host, self.port, "GET", "/", timeout=2)
+                return
+            except (OSError, asyncio.TimeoutError, IndexError, ValueError):
+                await asyncio.sleep(0.5)
+        raise SystemExit(f"No web server at {self.args.url}")
+
+    async def sse_client(self):
+        sensor_id = f"sensor/{self.args.intake_sensor}"
+        while not self.stop.is_set():
+            try:
+                reader, writer = await asyncio.open_connection(
+                    self.host, self.port
+                )
+            except OSError:
+                self.sse_dropped += 1
+                await asyncio.sleep(1)
+                continue
+            try:
+                writer.write(
+                    f"GET /events HTTP/1.1\r\nHost: {self.host}\r\n"
+                    "Accept: text/event-stream\r\n\r\n".encode()
+                )
+                await writer.drain()
+                await reader.readline()
+                headers = await read_headers(reader)
+                chunked = headers.get("transfer-encoding") == "chunked"
+                self.sse_connected += 1
+                event = "message"
+                async for line in iter_body_lines(reader, chunked):
+                    if self.stop.is_set():
+                        break
+                    if line.startswith("event:"):
+                        event = line[6:].strip()
+                        continue
+                    if not line:
+                        event = "message"
+                        continue
+                    # The dump on connect (state_detail_all) isn't fan-out.
+                    if event != "state" or not line.startswith("data:"):
+                        continue
+                    try:
+                        data = json.loads(line[5:])
+                    except ValueError:
+                        continue
+                    if data.get("id") != sensor_id:
+                        continue
+                    try:
+                        value = int(data["value"])
+                    except (KeyError, TypeError, ValueError, OverflowError):
+                        # e.g. NaN while the sensor has no reading.
+                        self.sse_bad_values += 1
+                        continue
+                    reported = self.intake_reported_at.get(value)
+                    if reported is not None:
+                        self.fanout_latency.append(time.monotonic() - reported)
+            except (OSError, asyncio.IncompleteReadError):
+                pass
+            finally:
+                writer.close()
+            if not self.stop.is_set():
+                self.sse_dropped += 1
+
+    async def command_client(self, temps):
+        path = f"/climate/{urllib.parse.quote(self.args.climate)}/set"
+        while not self.stop.is_set():
+            fahrenheit = next(temps)
+            celsius = round((fahrenheit - 32) * 5 / 9, 2)
+            self.expect_frame(sim_board.SET_TEMPERATURE, fahrenheit)
+            try:
+                status = await http_request(
+                    self.host, self.port, "POST",
+                    f"{path}?target_temperature={celsius}",
+                )
+                if status != 200:
+                    self.command_errors += 1
+            except (OSError, asyncio.TimeoutError, IndexError, ValueError):
+                self.command_errors += 1
+            await asyncio.sleep(self.args.command_interval)
+
+    async def drive_intake(self):
+        # Walk the intake temperature so every SSE client sees a change.
+        temp = 20
+        while not self.stop.is_set():
+            temp = 20 if temp >= 35 else temp + 1
+            self.intake_reported_at.pop(temp, None)
+            self.board.set_value(sim_board.INTAKE_TEMP, temp)
+            await asyncio.sleep(self.args.intake_interval)
+
+    async def sample_rss(self, pid):
+        while not self.stop.is_set():
+            kib = rss_kib(pid)
+            if kib is not None:
+                self.rss.append(kib)
+            await asyncio.sleep(1)
+
+    def temps(self):
+        # Distinct setpoints so each command can be matched to its frame.
+        while True:
+            yield from range(63, 85)
+
+    async def run(self):
+        self.board.open()
+        try:
+            pid = self.args.pid
+            if self.args.binary:
+                self.proc = await asyncio.create_subprocess_exec(
+                    self.args.binary,
+                    stdout=asyncio.subprocess.DEVNULL,
+                    stderr=asyncio.subprocess.DEVNULL,
+                )
+                pid = self.proc.pid
+            await self.wait_for_server()
+
+            temps = self.temps()
+            tasks = [asyncio.create_task(self.drive_intake())]
+            if pid:
+                tasks.append(asyncio.create_task(self.sample_rss(pid)))
+            tasks += [
+                asyncio.create_task(self.sse_client())
+                for _ in range(self.args.sse_clients)
+            ]
+            tasks += [
+                asyncio.create_task(self.command_client(temps))
+                for _ in range(self.args.command_clients)
+            ]
+            await asyncio.sleep(self.args.duration)
+            self.stop.set()
+            for task in tasks:
+                task.cancel()
+            results = await asyncio.gather(*tasks, return_exceptions=True)
+            # A client that died early would otherwise just go quiet.
+            self.task_errors = [
+                r for r in results
+                if isinstance(r, Exception)
+                and not isinstance(r, asyncio.CancelledError)
+            ]
+            self.commands_unmatched += len(self.pending_commands)
+        finally:
+            if self.proc and self.proc.returncode is None:
+                self.proc.terminate()
+                await self.proc.wait()
+            self.board.close()
+
+    def report(self):
+        print(f"Duration:           {self.args.duration}s")
+        print(f"Board frames:       rx={self.board.num_rx} "
+              f"tx={self.board.num_tx} failed={self.board.parser.num_failed}")
+        print(f"Command latency:    {percentiles(self.command_latency)} "
+              f"errors={self.command_errors} "
+              f"unmatched={self.commands_unmatched}")
+        print(f"SSE fan-out:        {percentiles(self.fanout_latency)} "
+              f"connects={self.sse_connected} drops={self.sse_dropped} "
+              f"bad_values={self.sse_bad_values}")
+        for err in self.task_errors:
+            print(f"Client task failed: {err!r}")
+        if self.rss:
+            print(f"RSS:                start={self.rss[0]}KiB "
+                  f"end={self.rss[-1]}KiB max={max(self.rss)}KiB "
+                  f"growth={self.rss[-1] - self.rss[0]}KiB "
+                  f"median={statistics.median(self.rss):.0f}KiB")
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__.splitlines()[0],
+        formatter_class=argparse.ArgumentDefaultsHelpFormatter,
+    )
+    parser.add_argument("--url", default="http://127.0.0.1:8080",
+                        help="device web server")
+    parser.add_argument("--pty", default="/tmp/outequip-ac-pty",
+                        help="where the host build's uart port points")
+    parser.add_argument("--binary",
+                        help="host program to launch once the pty exists")
+    parser.add_argument("--pid", type=int,
+                        help="already running device process, for RSS")
+    parser.add_argument("--duration", type=float, default=60)
+    parser.add_argument("--sse-clients", type=int, default=32)
+    parser.add_argument("--command-clients", type=int, default=8)
+    parser.add_argument("--command-interval", type=float, default=0.5,
+                        help="pause between each client's commands (s)")
+    parser.add_argument("--intake-interval", type=float, default=2,
+                        help="how often the board's intake temp changes (s)")
+    parser.add_argument("--climate", default="Thermostat",
+                        help="climate entity name")
+    parser.add_argument("--intake-sensor", default="Intake Air Temp",
+                        help="intake temperature sensor name")
+    args = parser.parse_args()
+    if args.command_clients > 20:
+        parser.error("at most 20 command clients, so setpoints stay distinct")
+
+    test = LoadTest(args)
+    try:
+        asyncio.run(test.run())
+    except KeyboardInterrupt:
+        pass
+    test.report()
+
+
+if __name__ == "__main__":
+    main()
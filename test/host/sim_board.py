@@ -0,0 +1,211 @@
+#!/usr/bin/env python3
+"""Simulated OutEquip control board on a pseudo-terminal.
+
+Creates a pty, links its slave end at a fixed path for the host build's
+`uart: port:` to open, and answers frames the way the real board does (see
+protocol.md): a query (value 0) is answered with the current value. A set is
+stored, but the reply carries the current value of the last *queried* key,
+not the key that was set. Turning the unit on turns the LCD back on, and
+Light reads back 1 whatever it was set to.
+
+Run on its own to drive a host build by hand, or import SimBoard from
+load_test.py.
+"""
+
+import argparse
+import asyncio
+import os
+import time
+import tty
+
+PREAMBLE = b"\x5a\x5a"
+POSTAMBLE = b"\x0d\x0a"
+DEVICE_TYPE = 0x01
+
+# Keys, see ACFramer::Key.
+POWER = 0x01
+MODE = 0x02
+SET_TEMPERATURE = 0x03
+FAN_SPEED = 0x04
+UNDERVOLT = 0x05
+OVERVOLT = 0x06
+INTAKE_TEMP = 0x07
+OUTLET_TEMP = 0x08
+LCD = 0x0A
+SWING = 0x10
+VOLTAGE = 0x12
+AMPERAGE = 0x13
+LIGHT = 0x1C
+ACTIVE = 0x42
+
+DEFAULT_STATE = {
+    POWER: 2,  # On
+    MODE: 1,  # Cool
+    SET_TEMPERATURE: 72,  # °F
+    FAN_SPEED: 3,
+    UNDERVOLT: 105,  # 10.5 V
+    OVERVOLT: 16,
+    INTAKE_TEMP: 25,  # °C
+    OUTLET_TEMP: 12,
+    LCD: 0,  # On
+    SWING: 1,
+    VOLTAGE: 128,  # 12.8 V
+    AMPERAGE: 0,
+    LIGHT: 1,
+    ACTIVE: 2,
+}
+
+
+def encode_frame(key, value):
+    payload = bytes([key]) + (
+        value.to_bytes(2, "big") if value > 0xFF else bytes([value])
+    )
+    head = PREAMBLE + bytes([len(POSTAMBLE) + 2 + len(payload), DEVICE_TYPE])
+    body = head + payload
+    return body + bytes([sum(body) & 0xFF]) + POSTAMBLE
+
+
+class FrameParser:
+    """Incremental parser; yields (key, value) for each valid frame."""
+
+    def __init__(self):
+        self.buf = bytearray()
+        self.num_failed = 0
+
+    def feed(self, data):
+        self.buf += data
+        while True:
+            start = self.buf.find(PREAMBLE)
+            if start < 0:
+                del self.buf[:-1]
+                return
+            del self.buf[:start]
+            if len(self.buf) < 3:
+                return
+            total = len(PREAMBLE) + 1 + self.buf[2]
+            if total > 10 or total < 8:
+                self.num_failed += 1
+                del self.buf[:1]
+                continue
+            if len(self.buf) < total:
+                return
+            frame = bytes(self.buf[:total])
+            del self.buf[:total]
+            if (
+                frame[-2:] != POSTAMBLE
+                or sum(frame[:-3]) & 0xFF != frame[-3]
+            ):
+                self.num_failed += 1
+                continue
+            key = frame[4]
+            value = int.from_bytes(frame[5:-3], "big")
+            yield key, value
+
+
+class SimBoard:
+    """Board simulator bound to the master end of a pty.
+
+    on_frame(key, value, now) is called for every frame received, and
+    on_reply(key, value, now) for every frame sent back.
+    """
+
+    def __init__(self, link_path, on_frame=None, on_reply=None):
+        self.link_path = link_path
+        self.state = dict(DEFAULT_STATE)
+        self.on_frame = on_frame
+        self.on_reply = on_reply
+        self.parser = FrameParser()
+        self.num_rx = 0
+        self.num_tx = 0
+        self.master = None
+        # Set replies echo this key, see protocol.md.
+        self.last_queried = None
+
+    def open(self):
+        self.master, slave = os.openpty()
+        tty.setraw(slave)
+        os.set_blocking(self.master, False)
+        slave_name = os.ttyname(slave)
+        # Keep the slave open so the pty survives the client reconnecting.
+        self._slave = slave
+        if os.path.lexists(self.link_path):
+            os.unlink(self.link_path)
+        os.symlink(slave_name, self.link_path)
+        asyncio.get_running_loop().add_reader(self.master, self._on_readable)
+        return slave_name
+
+    def close(self):
+        if self.master is not None:
+            asyncio.get_running_loop().remove_reader(self.master)
+            os.close(self.master)
+            os.close(self._slave)
+            self.master = None
+        if os.path.islink(self.link_path):
+            os.unlink(self.link_path)
+
+    def set_value(self, key, value):
+        """Change board-side state, as if someone used the unit's panel."""
+        if key == POWER and value == 2 and self.state[POWER] != 2:
+            self.state[LCD] = 0  # On.
+        self.state[key] = value
+
+    def read_value(self, key):
+        """Value the board reports for key, which isn't always the truth."""
+        if key == LIGHT:
+            return 1
+        return self.state[key]
+
+    def _on_readable(self):
+        try:
+            data = os.read(self.master, 256)
+        except BlockingIOError:
+            return
+        now = time.monotonic()
+        for key, value in self.parser.feed(data):
+            self.num_rx += 1
+            if self.on_frame:
+                self.on_frame(key, value, now)
+            if key not in self.state:
+                continue
+            if value == 0:
+                self.last_queried = key
+            else:
+                self.set_value(key, value)
+            reply_key = self.last_queried or key
+            reply = self.read_value(reply_key)
+            os.write(self.master, encode_frame(reply_key, reply))
+            self.num_tx += 1
+            if self.on_reply:
+                self.on_reply(reply_key, reply, now)
+
+
+async def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--pty", default="/tmp/outequip-ac-pty",
+                        help="path to link the pty slave at")
+    parser.add_argument("--verbose", action="store_true",
+                        help="print every frame")
+    args = parser.parse_args()
+
+    def log(direction):
+        return lambda key, value, now: print(
+            f"{now:.3f} {direction} key=0x{key:02x} value={value}"
+        )
+
+    board = SimBoard(
+        args.pty,
+        on_frame=log("rx") if args.verbose else None,
+        on_reply=log("tx") if args.verbose else None,
+    )
+    print(f"Simulated board on {board.open()}, linked at {args.pty}")
+    try:
+        await asyncio.Event().wait()
+    finally:
+        board.close()
+
+
+if __name__ == "__main__":
+    try:
+        asyncio.run(main())
+    except KeyboardInterrupt:
+        pass
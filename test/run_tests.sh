@@ -23,8 +23,16 @@ g++ -std=c++17 \
   -Icomponents/outequip_ac \
   -I"${BREW_PREFIX}/include" \
   -L"${BREW_PREFIX}/lib" \
-  test/test_native/ac_framer_test.cpp \
+  test/test_native/*_test.cpp \
   components/outequip_ac/ac_framer.cpp \
+  components/outequip_ac/event_log.cpp \
+  components/outequip_ac/hub_scheduler.cpp \
+  components/outequip_ac/link_benchmark.cpp \
+  components/outequip_ac/passthrough_arbiter.cpp \
+  components/outequip_ac/rule_engine.cpp \
+  components/outequip_ac/scene_planner.cpp \
+  components/outequip_ac/state_journal.cpp \
+  components/outequip_ac/telemetry_ring.cpp \
   -lgtest -lgtest_main -lgmock \
   -o test_framer
 
@@ -0,0 +1,98 @@
+#include "event_log.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace {
+
+std::string FormatSeq(const EventLog &log, uint32_t seq) {
+  EventLog::Event event;
+  if (!log.Get(seq, &event)) return "<missing>";
+  char buf[64];
+  EventLog::Format(event, buf, sizeof(buf));
+  return buf;
+}
+
+}  // namespace
+
+TEST(EventLogTest, RecordsAndFormatsOnDemand) {
+  EventLog log;
+  log.Record<EventLog::Id::StateChanged>(100, ACFramer::Key::Voltage, 124);
+  log.Record<EventLog::Id::Command>(200, ACFramer::Key::Mode, 1);
+  log.Record<EventLog::Id::FrameFailed>(300, 0, 7);
+  ASSERT_EQ(3u, log.next_seq());
+
+  EventLog::Event event;
+  ASSERT_TRUE(log.Get(0, &event));
+  EXPECT_EQ(100u, event.at);
+  EXPECT_EQ(EventLog::Id::StateChanged, event.id);
+  EXPECT_EQ("voltage changed to 12.4", FormatSeq(log, 0));
+  EXPECT_EQ("Setting mode to cool", FormatSeq(log, 1));
+  EXPECT_EQ("Dropped invalid frame after 7 bytes", FormatSeq(log, 2));
+}
+
+TEST(EventLogTest, FormatsSignedTemperatures) {
+  EventLog log;
+  log.Record<EventLog::Id::StateChanged>(0, ACFramer::Key::IntakeAirTemp,
+                                         0xFB);
+  EXPECT_EQ("intakeTemp changed to -5", FormatSeq(log, 0));
+}
+
+TEST(EventLogTest, LevelsBelowThresholdAreCompiledOut) {
+  static_assert(EventLog::LevelOf(EventLog::Id::FrameRx) ==
+                EventLog::Level::Verbose);
+  EventLog log;
+  log.Record<EventLog::Id::FrameRx>(0, ACFramer::Key::Power, 2);
+  log.Record<EventLog::Id::FrameTx>(0, ACFramer::Key::Power, 0);
+  EXPECT_EQ(OUTEQUIP_AC_EVENT_LEVEL > 0 ? 0u : 2u, log.next_seq());
+}
+
+TEST(EventLogTest, WarnLevelDropsInfoEvents) {
+  // What `event_level: WARN` sets OUTEQUIP_AC_EVENT_LEVEL to.
+  constexpr int kWarn = static_cast<int>(EventLog::Level::Warn);
+  EventLog log;
+  log.Record<EventLog::Id::Command, kWarn>(0, ACFramer::Key::Power, 2);
+  log.Record<EventLog::Id::StateChanged, kWarn>(0, ACFramer::Key::Power, 2);
+  EXPECT_EQ(0u, log.next_seq());
+
+  log.Record<EventLog::Id::FrameFailed, kWarn>(0, 0, 4);
+  EXPECT_EQ(1u, log.next_seq());
+}
+
+TEST(EventLogTest, RingOverwritesOldest) {
+  EventLog log;
+  for (uint32_t i = 0; i < EventLog::kCapacity + 5; ++i) {
+    log.Record<EventLog::Id::Command>(i, ACFramer::Key::FanSpeed, 1);
+  }
+  EXPECT_EQ(5u, log.first_seq());
+  EXPECT_EQ(5u, log.num_overwritten());
+
+  EventLog::Event event;
+  EXPECT_FALSE(log.Get(4, &event));
+  ASSERT_TRUE(log.Get(5, &event));
+  EXPECT_EQ(5u, event.at);
+  EXPECT_FALSE(log.Get(log.next_seq(), &event));
+}
+
+TEST(EventLogTest, ClampsReadPositionToHeldEvents) {
+  EventLog log;
+  for (uint32_t i = 0; i < EventLog::kCapacity + 5; ++i) {
+    log.Record<EventLog::Id::Command>(i, ACFramer::Key::FanSpeed, 1);
+  }
+  EXPECT_EQ(5u, log.ClampSeq(0));
+  EXPECT_EQ(10u, log.ClampSeq(10));
+  // A seq kept from before a reboot is past the head.
+  EXPECT_EQ(log.next_seq(), log.ClampSeq(log.next_seq() + 1000));
+  EXPECT_EQ(log.next_seq(), log.ClampSeq(UINT32_MAX));
+}
+
+TEST(EventLogTest, FormatTruncatesToBuffer) {
+  EventLog log;
+  log.Record<EventLog::Id::Command>(0, ACFramer::Key::SetTemperature, 72);
+  EventLog::Event event;
+  ASSERT_TRUE(log.Get(0, &event));
+  char buf[8];
+  EXPECT_EQ(7u, EventLog::Format(event, buf, sizeof(buf)));
+  EXPECT_STREQ("Setting", buf);
+}
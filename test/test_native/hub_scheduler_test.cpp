@@ -0,0 +1,84 @@
+#include "hub_scheduler.h"
+
+#include <gtest/gtest.h>
+
+TEST(HubSchedulerTest, SingleUnitStartsOncePerPeriod) {
+  HubScheduler scheduler(1000);
+  const size_t unit = scheduler.AddUnit();
+  EXPECT_TRUE(scheduler.TryStartCycle(unit, 1234));
+  EXPECT_FALSE(scheduler.TryStartCycle(unit, 1235));
+  EXPECT_FALSE(scheduler.TryStartCycle(unit, 2233));
+  EXPECT_TRUE(scheduler.TryStartCycle(unit, 2234));
+}
+
+TEST(HubSchedulerTest, UnitsStartInTheirOwnWindows) {
+  HubScheduler scheduler(1000);
+  const size_t front = scheduler.AddUnit();
+  const size_t rear = scheduler.AddUnit();
+
+  // Both start right away on their first cycle...
+  EXPECT_TRUE(scheduler.TryStartCycle(front, 10000));
+  EXPECT_TRUE(scheduler.TryStartCycle(rear, 10000));
+
+  // ...then settle into alternating half-periods.
+  EXPECT_FALSE(scheduler.TryStartCycle(rear, 11000));
+  EXPECT_TRUE(scheduler.TryStartCycle(front, 11000));
+  EXPECT_FALSE(scheduler.TryStartCycle(rear, 11499));
+  EXPECT_TRUE(scheduler.TryStartCycle(rear, 11500));
+  EXPECT_FALSE(scheduler.TryStartCycle(front, 11500));
+  EXPECT_FALSE(scheduler.TryStartCycle(front, 11999));
+  EXPECT_TRUE(scheduler.TryStartCycle(front, 12000));
+}
+
+TEST(HubSchedulerTest, OverdueUnitIsNotStarved) {
+  HubScheduler scheduler(1000);
+  scheduler.AddUnit();
+  const size_t rear = scheduler.AddUnit();
+  EXPECT_TRUE(scheduler.TryStartCycle(rear, 10000));
+
+  // Outside its window, but two periods late.
+  EXPECT_FALSE(scheduler.TryStartCycle(rear, 11100));
+  EXPECT_TRUE(scheduler.TryStartCycle(rear, 12100));
+}
+
+TEST(HubSchedulerTest, UnknownUnitNeverStarts) {
+  HubScheduler scheduler(1000);
+  EXPECT_FALSE(scheduler.TryStartCycle(0, 1000));
+}
+
+TEST(HubSchedulerTest, WritesStayInTheirWindow) {
+  HubScheduler scheduler(1000);
+  const size_t front = scheduler.AddUnit();
+  const size_t rear = scheduler.AddUnit();
+
+  EXPECT_TRUE(scheduler.InWindow(front, 10000));
+  EXPECT_FALSE(scheduler.InWindow(rear, 10000));
+  EXPECT_TRUE(scheduler.InWindow(front, 10499));
+  EXPECT_FALSE(scheduler.InWindow(front, 10500));
+  EXPECT_TRUE(scheduler.InWindow(rear, 10500));
+  EXPECT_TRUE(scheduler.InWindow(rear, 10999));
+}
+
+TEST(HubSchedulerTest, UnevenSplitCoversTheWholePeriod) {
+  HubScheduler scheduler(1000);
+  scheduler.AddUnit();
+  scheduler.AddUnit();
+  const size_t last = scheduler.AddUnit();
+
+  for (uint32_t now = 10000; now < 11000; now++) {
+    int owners = 0;
+    for (size_t unit = 0; unit <= last; unit++) {
+      owners += scheduler.InWindow(unit, now);
+    }
+    EXPECT_EQ(owners, 1) << now;
+  }
+  EXPECT_TRUE(scheduler.InWindow(last, 10999));
+}
+
+TEST(HubSchedulerTest, SingleUnitMayAlwaysWrite) {
+  HubScheduler scheduler(1000);
+  const size_t unit = scheduler.AddUnit();
+  for (uint32_t now = 0; now < 1000; now += 100) {
+    EXPECT_TRUE(scheduler.InWindow(unit, now));
+  }
+}
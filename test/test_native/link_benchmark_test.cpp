@@ -0,0 +1,97 @@
+#include "link_benchmark.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+LinkBenchmark::Counters Counters(uint32_t rx, uint32_t failed,
+                                 uint32_t spurious) {
+  return LinkBenchmark::Counters{rx, failed, spurious};
+}
+
+}  // namespace
+
+TEST(LinkBenchmarkTest, OneFrameInFlight) {
+  LinkBenchmark bench(250);
+  bench.Start(1000, 5000, Counters(0, 0, 0));
+  EXPECT_TRUE(bench.running());
+  EXPECT_TRUE(bench.ShouldSend(1000));
+  bench.OnSent(1000);
+  EXPECT_FALSE(bench.ShouldSend(1005));
+  bench.OnReply(1010);
+  EXPECT_TRUE(bench.ShouldSend(1010));
+}
+
+TEST(LinkBenchmarkTest, TimedOutFrameIsCountedAndResent) {
+  LinkBenchmark bench(250);
+  bench.Start(0, 5000, Counters(0, 0, 0));
+  bench.OnSent(0);
+  EXPECT_FALSE(bench.ShouldSend(249));
+  EXPECT_TRUE(bench.ShouldSend(250));
+  // A straggling reply to the abandoned frame isn't an RTT sample.
+  bench.OnReply(300);
+
+  const auto result = bench.Finish(1000, Counters(1, 0, 0));
+  EXPECT_FALSE(bench.running());
+  EXPECT_EQ(result.timeouts, 1u);
+  EXPECT_EQ(result.replies, 0u);
+}
+
+TEST(LinkBenchmarkTest, ReportsRateAndRttDistribution) {
+  LinkBenchmark bench(250);
+  bench.Start(0, 1000, Counters(10, 1, 3));
+  uint32_t now = 0;
+  // 19 quick round trips and one slow one.
+  for (int i = 0; i < 20; ++i) {
+    ASSERT_TRUE(bench.ShouldSend(now));
+    bench.OnSent(now);
+    now += i == 19 ? 40 : 10;
+    bench.OnReply(now);
+  }
+  EXPECT_FALSE(bench.Expired(now));
+  EXPECT_TRUE(bench.Expired(1000));
+
+  const auto result = bench.Finish(1000, Counters(28, 3, 7));
+  EXPECT_EQ(result.replies, 20u);
+  EXPECT_FLOAT_EQ(result.frame_rate, 20.0f);
+  EXPECT_FLOAT_EQ(result.rtt_median_ms, 10.0f);
+  EXPECT_FLOAT_EQ(result.rtt_p95_ms, 10.0f);
+  EXPECT_FLOAT_EQ(result.rtt_max_ms, 40.0f);
+  // 2 failed against 18 good frames since the start.
+  EXPECT_FLOAT_EQ(result.failure_rate, 10.0f);
+  EXPECT_EQ(result.spurious_bytes, 4u);
+}
+
+TEST(LinkBenchmarkTest, SlowRepliesLandInTheOverflowBucket) {
+  LinkBenchmark bench(1000);
+  bench.Start(0, 10000, Counters(0, 0, 0));
+  uint32_t now = 0;
+  // 18 quick replies and 2 outliers, the worst at 500 ms.
+  for (int i = 0; i < 20; ++i) {
+    bench.OnSent(now);
+    now += i == 5 ? 300 : i == 12 ? 500 : 10;
+    bench.OnReply(now);
+  }
+
+  const auto result = bench.Finish(now, Counters(20, 0, 0));
+  EXPECT_EQ(result.slow_replies, 2u);
+  EXPECT_FLOAT_EQ(result.rtt_median_ms, 10.0f);
+  // Not clamped to the histogram's 127 ms.
+  EXPECT_FLOAT_EQ(result.rtt_p95_ms, 500.0f);
+  EXPECT_FLOAT_EQ(result.rtt_max_ms, 500.0f);
+}
+
+TEST(LinkBenchmarkTest, RestartClearsPreviousRun) {
+  LinkBenchmark bench(250);
+  bench.Start(0, 1000, Counters(0, 0, 0));
+  bench.OnSent(0);
+  bench.OnReply(50);
+  bench.Finish(1000, Counters(1, 0, 0));
+
+  bench.Start(2000, 1000, Counters(1, 0, 0));
+  const auto result = bench.Finish(3000, Counters(1, 0, 0));
+  EXPECT_EQ(result.replies, 0u);
+  EXPECT_FLOAT_EQ(result.rtt_max_ms, 0.0f);
+  EXPECT_FLOAT_EQ(result.failure_rate, 0.0f);
+  EXPECT_FLOAT_EQ(result.frame_rate, 0.0f);
+}
@@ -0,0 +1,201 @@
+#include "passthrough_arbiter.h"
+
+#include <gtest/gtest.h>
+
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Simulated control board: answers each complete frame it receives with one
+// frame for the same key, echoing set values and remembering them.
+class SimBoard {
+ public:
+  std::vector<uint8_t> Receive(const uint8_t *data, size_t len) {
+    std::vector<uint8_t> reply;
+    for (size_t i = 0; i < len; ++i) {
+      received_.push_back(data[i]);
+      if (!framer_.FrameData(data[i])) {
+        framer_.Reset();
+        continue;
+      }
+      if (!framer_.HasFullFrame()) continue;
+      const auto key = framer_.GetKey();
+      uint16_t &value = values_[static_cast<uint8_t>(key)];
+      if (framer_.GetValue() != ACFramer::kQueryVal) value = framer_.GetValue();
+      ACFramer out;
+      out.NewFrame(key, value, true);
+      reply.insert(reply.end(), out.buffer(), out.buffer() + out.buffer_pos());
+      framer_.Reset();
+    }
+    return reply;
+  }
+
+  std::vector<uint8_t> received_;
+  uint16_t values_[256] = {};
+
+ private:
+  ACFramer framer_;
+};
+
+std::vector<uint8_t> Frame(ACFramer::Key key, uint16_t value) {
+  ACFramer f;
+  f.NewFrame(key, value);
+  return std::vector<uint8_t>(f.buffer(), f.buffer() + f.buffer_pos());
+}
+
+}  // namespace
+
+class PassthroughArbiterTest : public ::testing::Test {
+ protected:
+  PassthroughArbiterTest()
+      : arbiter_(
+            [this](const uint8_t *d, size_t n) {
+              // Board replies arrive later, when the test pumps them.
+              auto reply = board_.Receive(d, n);
+              board_tx_.insert(board_tx_.end(), reply.begin(), reply.end());
+            },
+            [this](const uint8_t *d, size_t n) {
+              module_rx_.insert(module_rx_.end(), d, d + n);
+            },
+            [this](const ACFramer &f, bool local) {
+              frames_.emplace_back(f.GetKey(), local);
+            }) {}
+
+  // Deliver the board replies pending so far; replies to requests released
+  // while pumping wait for the next call.
+  void PumpBoard() {
+    for (size_t n = board_tx_.size(); n > 0; --n) {
+      uint8_t c = board_tx_.front();
+      board_tx_.pop_front();
+      arbiter_.OnBoardByte(c, now_);
+    }
+  }
+
+  void AppSends(const std::vector<uint8_t> &bytes) {
+    for (auto c : bytes) arbiter_.OnModuleByte(c, now_);
+  }
+
+  SimBoard board_;
+  std::deque<uint8_t> board_tx_;
+  std::vector<uint8_t> module_rx_;
+  std::vector<std::pair<ACFramer::Key, bool>> frames_;
+  uint32_t now_ = 1000;
+  PassthroughArbiter arbiter_;
+};
+
+TEST_F(PassthroughArbiterTest, ForwardsAppRequestAndSnoopsReply) {
+  const auto query = Frame(ACFramer::Key::Mode, ACFramer::kQueryVal);
+  board_.values_[static_cast<uint8_t>(ACFramer::Key::Mode)] = 2;
+  AppSends(query);
+  EXPECT_EQ(query, board_.received_);
+  EXPECT_EQ(PassthroughArbiter::Owner::App, arbiter_.owner());
+  EXPECT_FALSE(arbiter_.CanSendLocal(now_ + 1000));
+
+  PumpBoard();
+  EXPECT_EQ(Frame(ACFramer::Key::Mode, 2), module_rx_);
+  ASSERT_EQ(1u, frames_.size());
+  EXPECT_EQ(ACFramer::Key::Mode, frames_[0].first);
+  EXPECT_FALSE(frames_[0].second);
+  EXPECT_EQ(PassthroughArbiter::Owner::None, arbiter_.owner());
+  EXPECT_EQ(1u, arbiter_.num_app_frames());
+}
+
+TEST_F(PassthroughArbiterTest, LocalReplyIsNotForwardedToModule) {
+  ACFramer query;
+  query.NewFrame(ACFramer::Key::Voltage, ACFramer::kQueryVal);
+  ASSERT_TRUE(arbiter_.SendLocal(query, now_));
+  EXPECT_EQ(PassthroughArbiter::Owner::Local, arbiter_.owner());
+
+  PumpBoard();
+  EXPECT_TRUE(module_rx_.empty());
+  ASSERT_EQ(1u, frames_.size());
+  EXPECT_TRUE(frames_[0].second);
+  EXPECT_TRUE(arbiter_.CanSendLocal(now_));
+}
+
+TEST_F(PassthroughArbiterTest, HoldsAppRequestUntilLocalReply) {
+  ACFramer query;
+  query.NewFrame(ACFramer::Key::Voltage, ACFramer::kQueryVal);
+  ASSERT_TRUE(arbiter_.SendLocal(query, now_));
+  const size_t sent_to_board = board_.received_.size();
+
+  const auto app_query = Frame(ACFramer::Key::IntakeAirTemp, 0);
+  AppSends(app_query);
+  EXPECT_EQ(sent_to_board, board_.received_.size());
+
+  // Our reply releases the app's request, which then owns the board.
+  PumpBoard();
+  EXPECT_EQ(sent_to_board + app_query.size(), board_.received_.size());
+  EXPECT_EQ(PassthroughArbiter::Owner::App, arbiter_.owner());
+  EXPECT_FALSE(arbiter_.SendLocal(query, now_ + 1));
+
+  PumpBoard();
+  EXPECT_EQ(Frame(ACFramer::Key::IntakeAirTemp, 0), module_rx_);
+  ASSERT_EQ(2u, frames_.size());
+  EXPECT_TRUE(frames_[0].second);
+  EXPECT_FALSE(frames_[1].second);
+}
+
+TEST_F(PassthroughArbiterTest, WaitsForIdleGapAndCompleteAppFrame) {
+  const auto app_query = Frame(ACFramer::Key::Power, 0);
+  AppSends(std::vector<uint8_t>(app_query.begin(), app_query.begin() + 3));
+  EXPECT_FALSE(arbiter_.CanSendLocal(now_ + PassthroughArbiter::kIdleGapMs));
+
+  AppSends(std::vector<uint8_t>(app_query.begin() + 3, app_query.end()));
+  PumpBoard();
+  EXPECT_FALSE(arbiter_.CanSendLocal(now_ + 1));
+  EXPECT_TRUE(arbiter_.CanSendLocal(now_ + PassthroughArbiter::kIdleGapMs));
+}
+
+TEST_F(PassthroughArbiterTest, TimeoutReleasesBoard) {
+  ACFramer query;
+  query.NewFrame(ACFramer::Key::Voltage, ACFramer::kQueryVal);
+  ASSERT_TRUE(arbiter_.SendLocal(query, now_));
+  board_tx_.clear();  // Board never answers.
+
+  arbiter_.Poll(now_ + PassthroughArbiter::kResponseTimeoutMs - 1);
+  EXPECT_EQ(PassthroughArbiter::Owner::Local, arbiter_.owner());
+  arbiter_.Poll(now_ + PassthroughArbiter::kResponseTimeoutMs);
+  EXPECT_EQ(PassthroughArbiter::Owner::None, arbiter_.owner());
+}
+
+TEST_F(PassthroughArbiterTest, ForwardsNonFrameBytesBothWays) {
+  const std::string at_query = "AT+NAME?\r\n";
+  for (auto c : at_query) arbiter_.OnBoardByte(c, now_);
+  EXPECT_EQ(std::vector<uint8_t>(at_query.begin(), at_query.end()), module_rx_);
+
+  const std::string at_reply = "\r\n+NAME:KT2025040004510\r\nOK\r\n";
+  AppSends(std::vector<uint8_t>(at_reply.begin(), at_reply.end()));
+  EXPECT_EQ(std::vector<uint8_t>(at_reply.begin(), at_reply.end()),
+            board_.received_);
+  EXPECT_EQ(PassthroughArbiter::Owner::None, arbiter_.owner());
+  EXPECT_TRUE(frames_.empty());
+}
+
+TEST_F(PassthroughArbiterTest, CountsBoardLineErrors) {
+  std::vector<std::pair<uint8_t, size_t>> errors;
+  arbiter_.set_on_board_error([&errors](uint8_t c, size_t frame_len) {
+    errors.emplace_back(c, frame_len);
+  });
+
+  // AT text for the module isn't noise.
+  const std::string at_query = "AT+NAME?\r\n";
+  for (auto c : at_query) arbiter_.OnBoardByte(c, now_);
+  EXPECT_EQ(0u, arbiter_.num_spurious_bytes_rx());
+
+  arbiter_.OnBoardByte(0xff, now_);
+  EXPECT_EQ(1u, arbiter_.num_spurious_bytes_rx());
+
+  // A frame with a bad checksum still reaches the module, but is counted.
+  auto frame = Frame(ACFramer::Key::Mode, 1);
+  frame[frame.size() - 3] ^= 0xff;
+  for (auto c : frame) arbiter_.OnBoardByte(c, now_);
+  EXPECT_EQ(1u, arbiter_.num_frames_failed());
+  EXPECT_TRUE(frames_.empty());
+  ASSERT_EQ(2u, errors.size());
+  EXPECT_EQ(0u, errors[0].second);
+  EXPECT_GT(errors[1].second, 0u);
+}
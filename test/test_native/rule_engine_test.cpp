@@ -0,0 +1,110 @@
+#include "rule_engine.h"
+
+#include <gtest/gtest.h>
+
+#include <utility>
+#include <vector>
+
+class RuleEngineTest : public ::testing::Test {
+ protected:
+  RuleEngineTest() {
+    engine_.set_action_fn(
+        [this](size_t rule, bool cleared, const RuleEngine::Action &) {
+          fired_.emplace_back(rule, cleared);
+        });
+  }
+
+  RuleEngine::Action Mode(int16_t mode) {
+    RuleEngine::Action action;
+    action.mode = mode;
+    return action;
+  }
+
+  RuleEngine engine_;
+  std::vector<std::pair<size_t, bool>> fired_;
+};
+
+TEST_F(RuleEngineTest, ThresholdBelowWithHysteresis) {
+  const size_t low_voltage =
+      engine_.AddThreshold(RuleEngine::Input::Voltage, 11.8f, false, 0.6f);
+  engine_.then(low_voltage) = Mode(0);
+  engine_.on_clear(low_voltage) = Mode(2);
+
+  engine_.SetInput(RuleEngine::Input::Voltage, 12.6f);
+  EXPECT_TRUE(fired_.empty());
+
+  engine_.SetInput(RuleEngine::Input::Voltage, 11.7f);
+  ASSERT_EQ(1u, fired_.size());
+  EXPECT_EQ(std::make_pair(low_voltage, false), fired_[0]);
+  EXPECT_TRUE(engine_.IsActive(low_voltage));
+
+  // Recovering a little isn't enough.
+  engine_.SetInput(RuleEngine::Input::Voltage, 12.0f);
+  engine_.SetInput(RuleEngine::Input::Voltage, 11.5f);
+  EXPECT_EQ(1u, fired_.size());
+
+  engine_.SetInput(RuleEngine::Input::Voltage, 12.5f);
+  ASSERT_EQ(2u, fired_.size());
+  EXPECT_EQ(std::make_pair(low_voltage, true), fired_[1]);
+}
+
+TEST_F(RuleEngineTest, ActiveOnFirstReading) {
+  const size_t hot =
+      engine_.AddThreshold(RuleEngine::Input::IntakeTemp, 30, true, 1);
+  engine_.then(hot) = Mode(2);
+  engine_.SetInput(RuleEngine::Input::IntakeTemp, 32);
+  ASSERT_EQ(1u, fired_.size());
+  EXPECT_EQ(std::make_pair(hot, false), fired_[0]);
+}
+
+TEST_F(RuleEngineTest, OnlyRulesForChangedInputAreEvaluated) {
+  const size_t hot =
+      engine_.AddThreshold(RuleEngine::Input::IntakeTemp, 30, true, 1);
+  engine_.then(hot) = Mode(2);
+  const size_t low_voltage =
+      engine_.AddThreshold(RuleEngine::Input::Voltage, 11.8f, false, 0.6f);
+  engine_.then(low_voltage) = Mode(0);
+
+  engine_.SetInput(RuleEngine::Input::Voltage, 11.0f);
+  EXPECT_FALSE(engine_.IsActive(hot));
+  ASSERT_EQ(1u, fired_.size());
+  EXPECT_EQ(low_voltage, fired_[0].first);
+}
+
+TEST_F(RuleEngineTest, EmptyActionsDoNotFire) {
+  const size_t hot =
+      engine_.AddThreshold(RuleEngine::Input::IntakeTemp, 30, true, 0);
+  engine_.then(hot) = Mode(2);
+  engine_.SetInput(RuleEngine::Input::IntakeTemp, 31);
+  engine_.SetInput(RuleEngine::Input::IntakeTemp, 29);
+  EXPECT_EQ(1u, fired_.size());
+  EXPECT_FALSE(engine_.IsActive(hot));
+}
+
+TEST_F(RuleEngineTest, ScheduleFiresWhenClockPassesIt) {
+  const size_t setback = engine_.AddSchedule(22 * 60 + 30);
+  engine_.then(setback).target_temperature = 20;
+
+  // The first reading only sets the clock, even if past the schedule.
+  engine_.SetInput(RuleEngine::Input::MinuteOfDay, 22 * 60 + 31);
+  EXPECT_TRUE(fired_.empty());
+
+  // Round through midnight to just before it the next day.
+  engine_.SetInput(RuleEngine::Input::MinuteOfDay, 23 * 60);
+  engine_.SetInput(RuleEngine::Input::MinuteOfDay, 22 * 60 + 29);
+  EXPECT_TRUE(fired_.empty());
+
+  engine_.SetInput(RuleEngine::Input::MinuteOfDay, 22 * 60 + 30);
+  ASSERT_EQ(1u, fired_.size());
+  EXPECT_EQ(std::make_pair(setback, false), fired_[0]);
+}
+
+TEST_F(RuleEngineTest, ScheduleAtMidnight) {
+  const size_t midnight = engine_.AddSchedule(0);
+  engine_.then(midnight) = Mode(3);
+  engine_.SetInput(RuleEngine::Input::MinuteOfDay, 23 * 60 + 59);
+  engine_.SetInput(RuleEngine::Input::MinuteOfDay, 0);
+  ASSERT_EQ(1u, fired_.size());
+  engine_.SetInput(RuleEngine::Input::MinuteOfDay, 1);
+  EXPECT_EQ(1u, fired_.size());
+}
@@ -0,0 +1,156 @@
+#include "scene_planner.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace {
+
+using Key = ACFramer::Key;
+
+std::vector<Key> Keys(const std::vector<ScenePlanner::Step> &steps) {
+  std::vector<Key> keys;
+  for (const auto &step : steps) keys.push_back(step.key);
+  return keys;
+}
+
+}  // namespace
+
+class ScenePlannerTest : public ::testing::Test {
+ protected:
+  void BoardReports(Key key, uint16_t value) {
+    planner_.OnBoardValue(key, value);
+  }
+
+  ScenePlanner planner_;
+};
+
+TEST_F(ScenePlannerTest, UnknownStateSendsEverythingInSafeOrder) {
+  ScenePlanner::Scene scene;
+  scene.Set(Key::Light, 1);
+  scene.Set(Key::Power, 2);
+  scene.Set(Key::FanSpeed, 5);
+  scene.Set(Key::LCD, 2);
+  scene.Set(Key::SetTemperature, 72);
+  scene.Set(Key::Mode, 1);
+
+  const auto steps = planner_.Plan(scene);
+  EXPECT_EQ((std::vector<Key>{Key::Mode, Key::SetTemperature, Key::FanSpeed,
+                              Key::Power, Key::LCD, Key::Light}),
+            Keys(steps));
+  EXPECT_TRUE(planner_.HasPending());
+}
+
+TEST_F(ScenePlannerTest, SkipsKeysAlreadyAtWantedValue) {
+  BoardReports(Key::Power, 2);
+  BoardReports(Key::Mode, 1);
+  BoardReports(Key::SetTemperature, 70);
+
+  ScenePlanner::Scene scene;
+  scene.Set(Key::Mode, 1);
+  scene.Set(Key::Power, 2);
+  scene.Set(Key::SetTemperature, 72);
+
+  const auto steps = planner_.Plan(scene);
+  ASSERT_EQ(1u, steps.size());
+  EXPECT_EQ(Key::SetTemperature, steps[0].key);
+  EXPECT_EQ(72, steps[0].value);
+}
+
+TEST_F(ScenePlannerTest, PendingStepsAreNotResent) {
+  ScenePlanner::Scene scene;
+  scene.Set(Key::FanSpeed, 3);
+  EXPECT_EQ(1u, planner_.Plan(scene).size());
+  EXPECT_TRUE(planner_.Plan(scene).empty());
+
+  // A stale poll reply doesn't confirm it...
+  BoardReports(Key::FanSpeed, 1);
+  EXPECT_TRUE(planner_.HasPending());
+  // ...the echo does.
+  BoardReports(Key::FanSpeed, 3);
+  EXPECT_FALSE(planner_.HasPending());
+  EXPECT_TRUE(planner_.Plan(scene).empty());
+}
+
+TEST_F(ScenePlannerTest, ChangingAPendingValueSendsAgain) {
+  ScenePlanner::Scene scene;
+  scene.Set(Key::SetTemperature, 70);
+  planner_.Plan(scene);
+  scene.Set(Key::SetTemperature, 68);
+  const auto steps = planner_.Plan(scene);
+  ASSERT_EQ(1u, steps.size());
+  EXPECT_EQ(68, steps[0].value);
+}
+
+TEST_F(ScenePlannerTest, ClearPendingAllowsRetry) {
+  ScenePlanner::Scene scene;
+  scene.Set(Key::Power, 1);
+  planner_.Plan(scene);
+  planner_.ClearPending();
+  EXPECT_FALSE(planner_.HasPending());
+  EXPECT_EQ(1u, planner_.Plan(scene).size());
+}
+
+TEST_F(ScenePlannerTest, NormalizesReportedLcd) {
+  BoardReports(Key::LCD, 0);
+  EXPECT_EQ(static_cast<uint16_t>(ACFramer::OnOffValue::On),
+            planner_.confirmed(Key::LCD));
+  ScenePlanner::Scene scene;
+  scene.Set(Key::LCD, static_cast<uint16_t>(ACFramer::OnOffValue::On));
+  EXPECT_TRUE(planner_.Plan(scene).empty());
+}
+
+TEST_F(ScenePlannerTest, IgnoresNonSceneKeys) {
+  BoardReports(Key::Voltage, 128);
+  ScenePlanner::Scene scene;
+  scene.Set(Key::Voltage, 128);
+  EXPECT_FALSE(scene.Get(Key::Voltage).has_value());
+  EXPECT_TRUE(planner_.Plan(scene).empty());
+}
+
+TEST_F(ScenePlannerTest, LightIsFireAndForget) {
+  ScenePlanner::Scene scene;
+  scene.Set(Key::Light, static_cast<uint16_t>(ACFramer::LightValue::Off));
+
+  // Always sent, and never waits on a reply.
+  EXPECT_EQ((std::vector<Key>{Key::Light}), Keys(planner_.Plan(scene)));
+  EXPECT_FALSE(planner_.HasPending());
+  EXPECT_EQ((std::vector<Key>{Key::Light}), Keys(planner_.Plan(scene)));
+
+  // Board reads are ignored; writing the frame confirms it.
+  BoardReports(Key::Light, 1);
+  EXPECT_FALSE(planner_.confirmed(Key::Light).has_value());
+  planner_.OnWritten(Key::Light,
+                     static_cast<uint16_t>(ACFramer::LightValue::Off));
+  EXPECT_EQ(static_cast<uint16_t>(ACFramer::LightValue::Off),
+            planner_.confirmed(Key::Light));
+}
+
+TEST_F(ScenePlannerTest, PoweringOnAlwaysSetsLcdAfterwards) {
+  const auto off = static_cast<uint16_t>(ACFramer::OnOffValue::Off);
+  const auto on = static_cast<uint16_t>(ACFramer::OnOffValue::On);
+  // Off with the display off; powering on will turn the display back on.
+  BoardReports(Key::Power, off);
+  BoardReports(Key::LCD, off);
+
+  ScenePlanner::Scene scene;
+  scene.Set(Key::Power, on);
+  scene.Set(Key::LCD, off);
+  const auto steps = planner_.Plan(scene);
+  EXPECT_EQ((std::vector<Key>{Key::Power, Key::LCD}), Keys(steps));
+  EXPECT_EQ(off, steps[1].value);
+
+  // Once on, the display is diffed as usual.
+  BoardReports(Key::Power, on);
+  BoardReports(Key::LCD, off);
+  EXPECT_TRUE(planner_.Plan(scene).empty());
+}
+
+TEST_F(ScenePlannerTest, ClearedKeysAreLeftAlone) {
+  ScenePlanner::Scene scene;
+  scene.Set(Key::SetTemperature, 162);
+  scene.Set(Key::FanSpeed, 3);
+  scene.Clear(Key::SetTemperature);
+  EXPECT_FALSE(scene.Get(Key::SetTemperature).has_value());
+  EXPECT_EQ((std::vector<Key>{Key::FanSpeed}), Keys(planner_.Plan(scene)));
+}
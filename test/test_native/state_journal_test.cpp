@@ -0,0 +1,62 @@
+#include "state_journal.h"
+
+#include <gtest/gtest.h>
+
+class StateJournalTest : public ::testing::Test {
+ protected:
+  static const uint32_t kEpoch = 0x1234;
+  StateJournal journal_{kEpoch};
+};
+
+TEST_F(StateJournalTest, EmptyJournal) {
+  EXPECT_EQ(0, journal_.version());
+  EXPECT_FALSE(journal_.Has(StateJournal::Field::Mode));
+  EXPECT_FALSE(journal_.CanServeDelta(kEpoch, 0));
+}
+
+TEST_F(StateJournalTest, SetBumpsVersionOnlyOnChange) {
+  EXPECT_TRUE(journal_.Set(StateJournal::Field::TargetTemp, 22.0f));
+  EXPECT_EQ(1, journal_.version());
+  EXPECT_FALSE(journal_.Set(StateJournal::Field::TargetTemp, 22.0f));
+  EXPECT_EQ(1, journal_.version());
+  EXPECT_TRUE(journal_.Set(StateJournal::Field::TargetTemp, 23.0f));
+  EXPECT_EQ(2, journal_.version());
+  EXPECT_EQ(2, journal_.GetVersion(StateJournal::Field::TargetTemp));
+  EXPECT_FLOAT_EQ(23.0f, journal_.Get(StateJournal::Field::TargetTemp));
+}
+
+TEST_F(StateJournalTest, FirstSetOfZeroIsRecorded) {
+  EXPECT_TRUE(journal_.Set(StateJournal::Field::OutletTemp, 0.0f));
+  EXPECT_TRUE(journal_.Has(StateJournal::Field::OutletTemp));
+}
+
+TEST_F(StateJournalTest, ChangedSince) {
+  journal_.Set(StateJournal::Field::Mode, 2);
+  journal_.Set(StateJournal::Field::FanMode, 5);
+  const uint32_t synced = journal_.version();
+  journal_.Set(StateJournal::Field::IntakeTemp, 21);
+
+  EXPECT_TRUE(journal_.CanServeDelta(kEpoch, synced));
+  EXPECT_FALSE(journal_.ChangedSince(StateJournal::Field::Mode, synced));
+  EXPECT_FALSE(journal_.ChangedSince(StateJournal::Field::FanMode, synced));
+  EXPECT_TRUE(journal_.ChangedSince(StateJournal::Field::IntakeTemp, synced));
+  EXPECT_FALSE(journal_.ChangedSince(StateJournal::Field::OutletTemp, synced));
+}
+
+TEST_F(StateJournalTest, FullSnapshotOnEpochMismatchOrFutureVersion) {
+  journal_.Set(StateJournal::Field::Mode, 1);
+  EXPECT_TRUE(journal_.CanServeDelta(kEpoch, 1));
+  EXPECT_FALSE(journal_.CanServeDelta(kEpoch + 1, 1));
+  EXPECT_FALSE(journal_.CanServeDelta(kEpoch, 2));
+}
+
+TEST_F(StateJournalTest, FullSnapshotWhenGapTooLarge) {
+  journal_.Set(StateJournal::Field::IntakeTemp, 0);
+  const uint32_t synced = journal_.version();
+  for (uint32_t i = 1; i <= StateJournal::kMaxDeltaSpan; ++i) {
+    journal_.Set(StateJournal::Field::IntakeTemp, i);
+  }
+  EXPECT_TRUE(journal_.CanServeDelta(kEpoch, synced));
+  journal_.Set(StateJournal::Field::IntakeTemp, -1);
+  EXPECT_FALSE(journal_.CanServeDelta(kEpoch, synced));
+}
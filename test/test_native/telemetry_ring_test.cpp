@@ -0,0 +1,216 @@
+#include "telemetry_ring.h"
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <memory>
+#include <string>
+
+namespace {
+
+// Preferences stand-in: blocks by slot, plus the sent seq.
+struct FakeFlash {
+  std::map<size_t, TelemetryRing::Block> blocks;
+  uint32_t sent_seq = 0;
+  int writes = 0;
+  bool full = false;
+
+  void Attach(TelemetryRing &ring, size_t num_slots) {
+    ring.EnableFlash(
+        num_slots,
+        [this](size_t slot, TelemetryRing::Block *block) {
+          auto it = blocks.find(slot);
+          if (it == blocks.end()) return false;
+          *block = it->second;
+          return true;
+        },
+        [this](size_t slot, const TelemetryRing::Block &block) {
+          if (full) return false;
+          blocks[slot] = block;
+          writes++;
+          return true;
+        },
+        [this](uint32_t seq) {
+          sent_seq = seq;
+          return true;
+        },
+        sent_seq);
+  }
+};
+
+std::string Line(int i) {
+  // Padded so a handful of lines fill a flash block.
+  return "outequip-ac,host=van n=" + std::to_string(i) + "i" +
+         std::string(200, ' ');
+}
+
+}  // namespace
+
+TEST(TelemetryRingTest, PacketsCarryWallClockTimestamps) {
+  TelemetryRing ring(4096);
+  ring.Push("a v=1i", 1000, 1700000000);
+  ring.Push("b v=2i", 11000, 1700000010);
+  EXPECT_EQ(ring.size(), 2u);
+
+  EXPECT_EQ(ring.NextPacket(1400, 12000, 1700000011),
+            "a v=1i 1700000000000000000\nb v=2i 1700000010000000000\n");
+  EXPECT_TRUE(ring.empty());
+  EXPECT_EQ(ring.fill_bytes(), 0u);
+}
+
+TEST(TelemetryRingTest, UptimeStampsAreBackfilled) {
+  TelemetryRing ring(4096);
+  // Taken before the clock was set.
+  ring.Push("a v=1i", 5000, 0);
+  ring.Push("b v=2i", 65000, 0);
+
+  EXPECT_EQ(ring.NextPacket(1400, 125000, 1700000120),
+            "a v=1i 1700000000000000000\nb v=2i 1700000060000000000\n");
+}
+
+TEST(TelemetryRingTest, NoClockSendsLinesUnstamped) {
+  TelemetryRing ring(4096);
+  ring.Push("a v=1i", 5000, 0);
+  EXPECT_EQ(ring.NextPacket(1400, 6000, 0), "a v=1i\n");
+}
+
+TEST(TelemetryRingTest, PacketsAreLimitedInSize) {
+  TelemetryRing ring(4096);
+  ring.Push("aaaa", 0, 0);
+  ring.Push("bbbb", 0, 0);
+  ring.Push("cccccccccccc", 0, 0);
+
+  EXPECT_EQ(ring.NextPacket(10, 0, 0), "aaaa\nbbbb\n");
+  // Too long for any packet, so it goes alone.
+  EXPECT_EQ(ring.NextPacket(10, 0, 0), "cccccccccccc\n");
+  EXPECT_EQ(ring.NextPacket(10, 0, 0), "");
+}
+
+TEST(TelemetryRingTest, UndeliveredPacketsAreRequeued) {
+  TelemetryRing ring(4096);
+  ring.Push("aaaa", 0, 0);
+  ring.Push("bbbb", 0, 0);
+  ring.Push("cccc", 0, 0);
+
+  EXPECT_EQ(ring.NextPacket(10, 0, 0), "aaaa\nbbbb\n");
+  ring.Requeue();
+  EXPECT_EQ(ring.size(), 3u);
+  EXPECT_EQ(ring.NextPacket(10, 0, 0), "aaaa\nbbbb\n");
+  ring.Commit();
+  // Committed lines can't be put back.
+  ring.Requeue();
+  EXPECT_EQ(ring.NextPacket(10, 0, 0), "cccc\n");
+  EXPECT_EQ(ring.NextPacket(10, 0, 0), "");
+}
+
+TEST(TelemetryRingTest, DropsOldestWhenFullWithoutFlash) {
+  TelemetryRing ring(1024);
+  for (int i = 0; i < 20; ++i) ring.Push(Line(i), i, 1700000000 + i);
+  EXPECT_LE(ring.fill_bytes(), ring.capacity());
+  EXPECT_GT(ring.num_dropped(), 0u);
+  EXPECT_EQ(ring.num_dropped() + ring.size(), 20u);
+
+  // What's left is the newest lines, in order.
+  const std::string packet = ring.NextPacket(100000, 20, 1700000020);
+  const std::string oldest = "n=" + std::to_string(ring.num_dropped()) + "i";
+  EXPECT_EQ(packet.find(oldest), packet.find("n="));
+  EXPECT_NE(packet.find("n=19i"), std::string::npos);
+}
+
+TEST(TelemetryRingTest, SpillsWholeBlocksToFlashInOrder) {
+  FakeFlash flash;
+  TelemetryRing ring(1024);
+  flash.Attach(ring, 4);
+  for (int i = 0; i < 20; ++i) ring.Push(Line(i), i, 1700000000 + i);
+  EXPECT_EQ(ring.num_dropped(), 0u);
+  EXPECT_EQ(ring.size(), 20u);
+  // Three lines fit RAM and four fit a block. Only full blocks are written,
+  // so the last line spilled is still staged in RAM.
+  EXPECT_EQ(ring.num_spilled(), 17u);
+  EXPECT_EQ(flash.writes, 4);
+
+  std::string all;
+  std::string packet;
+  while (!(packet = ring.NextPacket(1400, 20, 1700000020)).empty()) {
+    all += packet;
+  }
+  size_t pos = 0;
+  for (int i = 0; i < 20; ++i) {
+    const size_t next = all.find("n=" + std::to_string(i) + "i", pos);
+    ASSERT_NE(next, std::string::npos) << i;
+    pos = next;
+  }
+  EXPECT_TRUE(ring.empty());
+  EXPECT_EQ(flash.sent_seq, static_cast<uint32_t>(flash.writes));
+}
+
+TEST(TelemetryRingTest, FlashIsMarkedSentOnlyOnceDelivered) {
+  FakeFlash flash;
+  TelemetryRing ring(1024);
+  flash.Attach(ring, 4);
+  for (int i = 0; i < 20; ++i) ring.Push(Line(i), i, 1700000000 + i);
+
+  // Everything fits one packet, which isn't delivered.
+  EXPECT_FALSE(ring.NextPacket(100000, 20, 1700000020).empty());
+  ring.Requeue();
+  EXPECT_EQ(flash.sent_seq, 0u);
+  EXPECT_EQ(ring.size(), 20u);
+
+  EXPECT_FALSE(ring.NextPacket(100000, 20, 1700000020).empty());
+  ring.Commit();
+  EXPECT_TRUE(ring.empty());
+  EXPECT_EQ(flash.sent_seq, static_cast<uint32_t>(flash.writes));
+}
+
+TEST(TelemetryRingTest, OldestFlashBlockMakesWayWhenFull) {
+  FakeFlash flash;
+  TelemetryRing ring(1024);
+  flash.Attach(ring, 2);
+  for (int i = 0; i < 40; ++i) ring.Push(Line(i), i, 1700000000 + i);
+  EXPECT_GT(ring.num_dropped(), 0u);
+  EXPECT_EQ(ring.num_dropped() + ring.size(), 40u);
+  EXPECT_EQ(flash.blocks.size(), 2u);
+}
+
+TEST(TelemetryRingTest, FailedFlashWritesAreCounted) {
+  FakeFlash flash;
+  flash.full = true;
+  TelemetryRing ring(1024);
+  flash.Attach(ring, 4);
+  for (int i = 0; i < 20; ++i) ring.Push(Line(i), i, 1700000000 + i);
+  // Same spill as above, but none of the four blocks could be saved.
+  EXPECT_EQ(ring.num_flash_write_failures(), 4u);
+  EXPECT_EQ(ring.num_dropped(), 16u);
+  EXPECT_EQ(ring.size(), 4u);
+  EXPECT_TRUE(flash.blocks.empty());
+}
+
+TEST(TelemetryRingTest, UnsentBlocksAreRestoredAfterReboot) {
+  FakeFlash flash;
+  {
+    TelemetryRing ring(1024);
+    flash.Attach(ring, 4);
+    for (int i = 0; i < 20; ++i) {
+      // The first few were taken before the clock was set.
+      ring.Push(Line(i), i, i < 2 ? 0 : 1700000000 + i);
+    }
+  }
+
+  TelemetryRing ring(1024);
+  flash.Attach(ring, 4);
+  std::string all;
+  std::string packet;
+  while (!(packet = ring.NextPacket(1400, 0, 1700000100)).empty()) {
+    all += packet;
+  }
+  // Uptime stamps from the last boot can't be backfilled.
+  EXPECT_EQ(all.find("n=0i"), std::string::npos);
+  EXPECT_EQ(all.find("n=1i"), std::string::npos);
+  EXPECT_NE(all.find("n=2i"), std::string::npos);
+  EXPECT_EQ(ring.num_dropped(), 2u);
+
+  // Once sent, they aren't restored again.
+  TelemetryRing rebooted(1024);
+  flash.Attach(rebooted, 4);
+  EXPECT_TRUE(rebooted.empty());
+}